@@ -6,15 +6,46 @@
  *
  * String properties:<br>
  * - Sum of elements 1+i.
- * - Representatives of orbits under the action of D_N.
+ * - Representatives of orbits under the action of D_N (with
+ * <b><tt>-u</tt></b>, of D_N and of multiplication of the conjugate by i).
  * - Orbit representatives must have <b>(1)</b> real-valued correlations, and
  * <b>(2)</b> have bounded square norm of nonprincipal character sums (<= 2N+2).
  *
- * Executable usage: <b><tt>./B <length> 1> <out_file></tt></b> <br>
+ * Executable usage: <b><tt>./B [-b] [-u] [-f filter] [-o out_file [-c seconds]
+ * [-r]] [-s i/m] [-e probes] [-p seconds] [-t stats_file] [-j threads]
+ * [-d depth] <length> 1> <out_file></tt></b> <br>
  * - <b><tt><length></tt></b> is a positive even integer denoting the length of
  * the strings to be generated.
+ * - <b><tt><threads></tt></b> is the number of worker threads (default: number
+ * of online processors).
+ * - <b><tt><depth></tt></b> is the prefix length at which the bracelet
+ * recursion is split into tasks (default: chosen automatically).
+ * - <b><tt>-u</tt></b> reduces the strings by multiplication of the conjugate
+ * by i as well (see Argsym), so that the B output is about halved. Match it
+ * against the output of A with <b><tt>-u</tt></b>.
+ * - <b><tt>-b</tt></b> writes binary records (see BINRECORD) instead of text
+ * lines; <b><tt>bin2txt</tt></b> converts them back.
+ * - <b><tt><filter></tt></b> is a filter file built by <b><tt>mkfilter</tt></b>
+ * from the output of A. Strings that cannot form a Legendre pair with any
+ * string of the filter are not written.
  * - The generated bracelets are written to stdout. This can be redirected to
- * an output file  <b><tt><out_file></tt></b> as shown above.
+ * an output file  <b><tt><out_file></tt></b> as shown above, or the file can
+ * be given with <b><tt>-o</tt></b>.
+ * - <b><tt>-c seconds</tt></b> saves a checkpoint to
+ * <b><tt><out_file>.ckpt</tt></b> that often (requires <b><tt>-o</tt></b>).
+ * After an interruption, the same command with <b><tt>-r</tt></b> added
+ * continues where the last checkpoint left off.
+ * - <b><tt>-s i/m</tt></b> runs only the i-th of m shards of roughly equal
+ * estimated cost (1 <= i <= m), e.g. on separate machines. The m outputs
+ * concatenated hold the output of the whole search.
+ * - <b><tt>-e probes</tt></b> prints an estimate of the size and running time
+ * of the search from that many random probes per content class instead of
+ * running it (see estimate.c).
+ * - <b><tt>-p seconds</tt></b> reports progress to stderr that often: counts
+ * and rates of nodes, strings and output, fraction done and time left. A
+ * summary of the counters is written as one line of JSON at the end.
+ * - <b><tt>-t stats_file</tt></b> appends the reports and the summary to
+ * <b><tt>stats_file</tt></b> instead.
  *
  * @author Thomas Pender
  */
@@ -22,156 +53,23 @@
 
 /* std headers */
 # include <stdio.h>
-# include <stddef.h>
 # include <stdlib.h>
-# include <libgen.h>
-# include <error.h>
-# include <errno.h>
 
 /* project headers */
 # include <defs.h>
 # include <legendre.h>
 
-# if HAVE_PTHREAD
-# include <pthread.h>
-# endif
-
-/**
- * @brief Holds data unique to each thread.
- */
-typedef struct {
-  unsigned N;           ///< string length
-  unsigned nonreal;     ///< number of \sqrt{-1}s in strings
-# if HAVE_PTHREAD
-  pthread_mutex_t *mtx; ///< dynamic mutex guarding stdout
-# endif
-} thread_args_t;
-
-/**
- * @brief Thread function to generate fixed content bracelets of a
- *        particular fixed type.
- *
- * Generates fixed content quaternary braceletes with real-valued periodic
- * auto-correlations. Braceletes must have bounded square norm <= 2N+2. The
- * sum of the entries must be 1+i.
- *
- * @param[in] _thread_args thread arguments (see thread_args_t)
- */
-void *thread_func_B(void *_thread_args)
-{
-  thread_args_t thread_args=*((thread_args_t*)_thread_args);
-
-  neck_t neck={.n=thread_args.N,
-               .k=(thread_args.nonreal==1 || thread_args.nonreal==thread_args.N/2) ?
-               3 : K,
-               .ncheckfuncs=2,.arginit=arginit,
-               .argfree=NULL,.seqprint=printseq};
-
-  neck.num=(unsigned*)calloc(neck.k+1,sizeof(unsigned));
-  neck.checkfuncs=(check_t*)malloc(neck.ncheckfuncs*sizeof(check_t));
-  neck.checkfuncs[0]=realcorrs;
-  neck.checkfuncs[1]=psdtest;
-
-  args_t args={.n=thread_args.N,.l=thread_args.N>>1U,.realcorrs=false};
-  args.corrs=(int*)calloc(args.l+1,sizeof(int));
-  args.nummap=(unsigned*)calloc(neck.k+1,sizeof(unsigned));
-  args.psdtable=Psdtable(args.n);
-
-  /* initialize bracelet arguments and necklace parameters */
-  if (neck.k==3) {
-    if (thread_args.nonreal==1) {
-      args.nummap[1]=1;
-      args.nummap[2]=2;
-      args.nummap[3]=0;
-    }
-    else {
-      args.nummap[1]=0;
-      args.nummap[2]=3;
-      args.nummap[3]=1;
-    }
-    neck.num[1]=1;
-    neck.num[2]=neck.n/2-1;
-    neck.num[3]=neck.n/2;
-  }
-  else if (thread_args.nonreal>neck.n/2) {
-    args.nummap[1]=2;
-    args.nummap[2]=0;
-    args.nummap[3]=3;
-    args.nummap[4]=1;
-    neck.num[1]=(neck.n+2)/2-thread_args.nonreal-1;
-    neck.num[2]=(neck.n+2)/2-thread_args.nonreal;
-    neck.num[3]=thread_args.nonreal-1;
-    neck.num[4]=thread_args.nonreal;
-  }
-  else {
-    args.nummap[1]=3;
-    args.nummap[2]=1;
-    args.nummap[3]=2;
-    args.nummap[4]=0;
-    neck.num[1]=thread_args.nonreal-1;
-    neck.num[2]=thread_args.nonreal;
-    neck.num[3]=(neck.n+2)/2-thread_args.nonreal-1;
-    neck.num[4]=(neck.n+2)/2-thread_args.nonreal;
-  }
-
-  FCBracelet(&neck,&args
-# if HAVE_PTHREAD
-             ,thread_args.mtx
-# endif
-             );
-
-  Argfree(&args);
-  Neckfree(&neck);
-
-  return NULL;
-}
-
 /**
  * @brief driver
  * @param[in] N Length of strings to be generated. Required to be even.
  */
 int main(int argc, char **argv)
 {
-  if (argc!=2)
-    error(1, errno, "usage -- %s <length>",basename(argv[0]));
-
-  int throw;
-  unsigned i, N, NUM_THREADS;
-  if (sscanf(argv[1],"%u",&N)==EOF)
-    error(1, errno, "sscanf failed");
-  if (N&1U)
-    error(1, errno, "<length> must be even");
-  NUM_THREADS=N/2;
-
-# if HAVE_PTHREAD
-  pthread_t threads[NUM_THREADS];
-  thread_args_t thread_args[NUM_THREADS];
-
-  pthread_mutex_t mtx;
-  pthread_mutex_init(&mtx,NULL);
-
-  for (i=0; i<NUM_THREADS; i++) {
-    thread_args[i].N=N;
-    thread_args[i].nonreal=i+1;
-    thread_args[i].mtx=&mtx;
-  }
-  for (i=0; i<NUM_THREADS; i++)
-    if ( (throw=pthread_create(&threads[i],NULL,
-                               thread_func_B,&thread_args[i])) != 0)
-      error(1, throw, "pthread_create failed");
-  for (i=0; i<NUM_THREADS; i++)
-    if ( (throw=pthread_join(threads[i],NULL)) != 0)
-      error(1, throw, "pthread_join failed");
-
-  pthread_mutex_destroy(&mtx);
-# else
-  thread_args_t thread_args;
-
-  for (i=0; i<NUM_THREADS; i++) {
-    thread_args.N=N;
-    thread_args.nonreal=i+1;
-    thread_func_B(&thread_args);
-  }
-# endif
+  search_t S={.classinit=Bclassinit,.kind='B'};
+  Searchopts(argc,argv,&S);
+  S.nclasses=S.reduce ? Bsymclasses(S.n) : Bclasses(S.n);
+  if (S.probes>0) Estimate(&S);
+  else Search(&S);
+  if (S.filter!=NULL) Bloomfree(S.filter);
   exit(0);
 }
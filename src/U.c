@@ -0,0 +1,66 @@
+/**
+ * @file U.c
+ *
+ * @brief Search for strings of either side of unrestricted quaternary Legendre
+ * pairs, whose correlations need not be real.
+ *
+ * String properties:<br>
+ * - Sum of elements 0 (<b><tt>-k A</tt></b>, the default) or 1+i
+ * (<b><tt>-k B</tt></b>), with the contents of the A and B classes.
+ * - Representatives of orbits under the action of D_N x {+1, i, -1, j} (A
+ * side) or of C_N (B side). Reversing a string conjugates its correlations,
+ * so only both strings of a pair may be reversed at once: the A side is
+ * reduced to bracelets, and the B side is searched as necklaces (see
+ * FCNecklace).
+ * - Orbit representatives must have bounded square norm of nonprincipal
+ * character sums (<= 2N+2) at all N-1 frequencies (see complexpsdtest).
+ * - Every string is written with its N-1 correlations Re c_j + Im c_j,
+ * j = 1..N-1 (see argcomplex). Those of the two strings of a Legendre pair
+ * sum to -2 at every shift, so <b><tt>match</tt></b> joins the outputs of
+ * <b><tt>U -k A</tt></b> and <b><tt>U -k B</tt></b> as it does those of A and
+ * B. The pairs of real correlations are found by A and B as well.
+ *
+ * Executable usage: <b><tt>./U [-k A|B] [-b] [-o out_file [-c seconds] [-r]]
+ * [-s i/m] [-e probes] [-p seconds] [-t stats_file] [-j threads] [-d depth]
+ * <length> 1> <out_file></tt></b> <br>
+ * - <b><tt><length></tt></b> is a positive even integer denoting the length of
+ * the strings to be generated.
+ * - The other options are those of A (see A.c). Filters (<b><tt>-f</tt></b>)
+ * and the reduction by symmetries (<b><tt>-u</tt></b>) are for real
+ * correlations only.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stdlib.h>
+# include <error.h>
+
+/* project headers */
+# include <defs.h>
+# include <legendre.h>
+
+/**
+ * @brief driver
+ * @param[in] N Length of strings to be generated. Required to be even.
+ */
+int main(int argc, char **argv)
+{
+  search_t S={.kind='a'};
+  Searchopts(argc,argv,&S);
+  if (S.filter!=NULL || S.reduce)
+    error(1, 0, "-f and -u require real correlations (A and B)");
+  if (S.kind=='a') {
+    S.classinit=UAclassinit;
+    S.nclasses=Aclasses(S.n);
+  }
+  else {
+    S.classinit=UBclassinit;
+    S.nclasses=Bclasses(S.n);
+  }
+  if (S.probes>0) Estimate(&S);
+  else Search(&S);
+  exit(0);
+}
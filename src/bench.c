@@ -0,0 +1,227 @@
+/**
+ * @file bench.c
+ *
+ * @brief Microbenchmarks of the hot paths of the searches.
+ *
+ * - <b><tt>arginit</tt></b>: correlations of whole strings (see arginit),
+ * drawn at random from the middle content class of A.
+ * - <b><tt>enumerate</tt></b> and <b><tt>nodes</tt></b>: the A search without
+ * checks, i.e. the bracelet recursion and the correlations of the strings
+ * generated (see arginit), per string generated and per node.
+ * - <b><tt>iterate</tt></b>: the same, pulling the strings from the iterative
+ * generator (see Braceletiter) instead of the recursion, per string.
+ * - <b><tt>psdtest</tt></b>: the PSD test of the strings generated by the A
+ * search. Each string is tested PSDREPS times; the time of the enumeration
+ * without checks is subtracted.
+ *
+ * Every result is written to stdout as one line of JSON, with the number of
+ * operations timed, the seconds taken, the rate per second and the
+ * nanoseconds per operation.
+ *
+ * Executable usage: <b><tt>./bench [-c count] <length> 1> <results></tt></b> <br>
+ * - <b><tt><length></tt></b> is a positive even integer denoting the length of
+ * the strings.
+ * - <b><tt><count></tt></b> is the number of strings of the
+ * <b><tt>arginit</tt></b> benchmark (default: 1048576).
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <time.h>
+# include <unistd.h>
+# include <libgen.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <defs.h>
+# include <legendre.h>
+
+# define POOL 4096  ///< number of distinct random strings of arginit
+# define PSDREPS 8  ///< number of times each string is tested by psdtest
+
+/** @cond */
+
+static unsigned reps; /* psdtest calls per string of the current run */
+static check_t psd;   /* psdtest of the string length (see Kernel) */
+
+static inline
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+1e-9*(double)ts.tv_nsec;
+}
+
+/* splitmix64 */
+static inline
+uint64_t rnd(uint64_t *state)
+{
+  uint64_t z=(*state+=UINT64_C(0x9e3779b97f4a7c15));
+  z=(z^(z>>30U))*UINT64_C(0xbf58476d1ce4e5b9);
+  z=(z^(z>>27U))*UINT64_C(0x94d049bb133111eb);
+  return z^(z>>31U);
+}
+
+static
+void result(const char *name, unsigned n, double count, double seconds)
+{
+  printf("{\"bench\":\"%s\",\"n\":%u,\"count\":%.0f,\"seconds\":%.6f,"
+         "\"rate\":%.6g,\"ns\":%.4g}\n",name,n,count,seconds,
+         seconds>0 ? count/seconds : 0,count>0 ? 1e9*seconds/count : 0);
+}
+
+static
+bool benchpsd(const void *_args)
+{
+  bool pass=true;
+  for (unsigned r=0; r<reps; r++) pass=psd(_args);
+  return pass;
+}
+
+static
+void noprint(const unsigned *a, const void *_args)
+{
+  (void)a;
+  (void)_args;
+}
+
+/* correlations of random strings of the middle content class of A */
+static
+void benchcorr(unsigned n, unsigned long count)
+{
+  neck_t neck;
+  args_t args;
+  unsigned *pool, *a, i, j, x, c, len=n+1;
+  uint64_t seed=UINT64_C(0x4c50514242454e31);
+  unsigned long r;
+  volatile int sink=0;
+  double t0;
+
+  Aclassinit(n,(Aclasses(n)-1)/2,&neck,&args);
+  pool=(unsigned*)malloc((size_t)POOL*len*sizeof(unsigned));
+  for (i=0; i<POOL; i++) {
+    a=pool+(size_t)i*len;
+    for (x=1, j=1; x<=neck.k; x++)
+      for (c=0; c<neck.num[x]; c++) a[j++]=x;
+    for (j=n; j>1; j--) { /* Fisher-Yates */
+      c=1+(unsigned)(rnd(&seed)%j);
+      x=a[j]; a[j]=a[c]; a[c]=x;
+    }
+  }
+  t0=now();
+  for (r=0; r<count; r++) {
+    neck.arginit(pool+(size_t)(r%POOL)*len,&args);
+    sink+=args.corrs[1];
+  }
+  result("arginit",n,(double)count,now()-t0);
+  (void)sink;
+  free(pool);
+  Argfree(&args);
+  Neckfree(&neck);
+}
+
+/* the A search with psdtest called r times per string, timed */
+static
+double enumerate(unsigned n, unsigned r, stats_t *T)
+{
+  neck_t neck;
+  args_t args;
+  check_t check=benchpsd;
+  double t0, t=0;
+
+  reps=r;
+  *T=(stats_t){0};
+  for (unsigned i=0; i<Aclasses(n); i++) {
+    Aclassinit(n,i,&neck,&args);
+    args.stats=T;
+    neck.ncheckfuncs=1;
+    free(neck.checkfuncs);
+    neck.checkfuncs=&check;
+    neck.seqprint=noprint;
+    t0=now();
+    FCBracelet(&neck,&args
+# if HAVE_PTHREAD
+               ,NULL
+# endif
+               );
+    t+=now()-t0;
+    T->nodes+=neck.nodes;
+    neck.checkfuncs=NULL;
+    neck.ncheckfuncs=0;
+    Argfree(&args);
+    Neckfree(&neck);
+  }
+  return t;
+}
+
+/* the A search without checks, pulled from the iterator, timed */
+static
+double iterate(unsigned n, double *count)
+{
+  neck_t neck;
+  args_t args;
+  iter_t *it;
+  double t0, t=0;
+
+  *count=0;
+  for (unsigned i=0; i<Aclasses(n); i++) {
+    Aclassinit(n,i,&neck,&args);
+    neck.ncheckfuncs=0;
+    t0=now();
+    it=Braceletiter(&neck,NULL,&args);
+    while (Iternext(it)!=NULL) (*count)++;
+    Iterfree(it);
+    t+=now()-t0;
+    Argfree(&args);
+    Neckfree(&neck);
+  }
+  return t;
+}
+
+/** @endcond */
+
+/**
+ * @brief driver
+ * @param[in] N Length of strings. Required to be even.
+ */
+int main(int argc, char **argv)
+{
+  stats_t T;
+  unsigned long count=1UL<<20U;
+  unsigned n;
+  double t0, t1, c;
+  int opt;
+
+  while ( (opt=getopt(argc,argv,"c:")) != -1) {
+    switch (opt) {
+    case 'c':
+      if (sscanf(optarg,"%lu",&count)!=1 || count==0)
+        error(1, 0, "<count> must be a positive integer");
+      break;
+    default:
+      error(1, 0, "usage -- %s [-c count] <length>", basename(argv[0]));
+    }
+  }
+  if (optind!=argc-1)
+    error(1, 0, "usage -- %s [-c count] <length>", basename(argv[0]));
+  if (sscanf(argv[optind],"%u",&n)!=1 || n<4 || n&1U)
+    error(1, 0, "<length> must be an even integer >= 4");
+
+  psd=Kernel(n)!=NULL ? Kernel(n)->psdtest : psdtest;
+  benchcorr(n,count);
+  t0=enumerate(n,0,&T);
+  result("enumerate",n,(double)T.strings,t0);
+  result("nodes",n,(double)T.nodes,t0);
+  t1=iterate(n,&c);
+  result("iterate",n,c,t1);
+  t1=enumerate(n,PSDREPS,&T);
+  result("psdtest",n,(double)PSDREPS*T.strings,t1>t0 ? t1-t0 : 0);
+  exit(0);
+}
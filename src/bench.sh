@@ -0,0 +1,107 @@
+#!/bin/sh
+#
+# bench.sh -- benchmarks of the searches and the matcher (run by 'make bench')
+#
+# usage: bench.sh <bin_dir> <data_dir> <results> <lengths> [<search_lengths>
+#        [<reps>]]
+#
+# For each length, runs the microbenchmarks of src/bench, then times A, B and
+# match end to end and checks the Legendre pairs found against
+# <data_dir>/len<length>/restricted.len<length>.txt. Every result is appended
+# to <results> as one line of JSON, tagged with the start time of the run, so
+# that the results of several runs can be compared. Exits nonzero if the pairs
+# of some length differ from the reference.
+#
+# For each of the search lengths, A and B are then timed on one thread (-j1),
+# the best of <reps> runs (default 3), and compared with the last run of the
+# same benchmark on the same host in <results>. These are the timings by which
+# changes to the searches are judged: the shorter lengths above take well
+# under a second and mostly time the start of the programs.
+#
+# author: Thomas Pender
+
+set -e
+
+bin=$1
+data=$2
+results=$3
+lengths=$4
+search_lengths=$5
+reps=${6:-3}
+run=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+host=$(uname -n)
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/bench.XXXXXX")
+trap 'rm -rf "$tmp"' EXIT
+status=0
+
+now() { date +%s.%N; }
+
+# append a result: name, length, seconds, further JSON fields
+emit() {
+  echo "{\"run\":\"$run\",\"host\":\"$host\",\"bench\":\"$1\",\"n\":$2,\"seconds\":$3$4}" >> "$results"
+}
+
+# pairs as sorted lines "A|B" (see ordered_check_sums for the format)
+blocks() {
+  awk 'BEGIN{RS="";FS="\n"}{print $1"|"$2}' "$1" | LC_ALL=C sort
+}
+
+# time a command: elapsed seconds to stdout
+timed() {
+  t0=$(now)
+  "$@"
+  t1=$(now)
+  awk -v a="$t0" -v b="$t1" 'BEGIN{printf "%.3f", b-a}'
+}
+
+for n in $lengths; do
+  ref=$data/len$n/restricted.len$n.txt
+  [ -f "$ref" ] || { echo "bench.sh: no reference for length $n" >&2; exit 1; }
+
+  "$bin/bench" $n | sed "s/^{/{\"run\":\"$run\",\"host\":\"$host\",/" >> "$results"
+
+  s=$(timed "$bin/A" -o "$tmp/A" $n)
+  emit A $n $s ",\"strings\":$(wc -l < "$tmp/A")"
+  s=$(timed "$bin/B" -o "$tmp/B" $n)
+  emit B $n $s ",\"strings\":$(wc -l < "$tmp/B")"
+  t0=$(now)
+  "$bin/match" "$tmp/A" "$tmp/B" > "$tmp/P"
+  s=$(awk -v a="$t0" -v b="$(now)" 'BEGIN{printf "%.3f", b-a}')
+
+  blocks "$tmp/P" > "$tmp/found"
+  blocks "$ref" > "$tmp/expected"
+  if cmp -s "$tmp/found" "$tmp/expected"; then ok=true; else ok=false; status=1; fi
+  emit match $n $s ",\"pairs\":$(wc -l < "$tmp/found"),\"ok\":$ok"
+  echo "length $n: A, B and match done, pairs $($ok && echo match || echo DIFFER) the reference"
+done
+
+# seconds of the last run of a benchmark on this host before the current run
+previous() {
+  [ -f "$results" ] || return 0
+  grep -F "\"host\":\"$host\",\"bench\":\"$1\",\"n\":$2," "$results" |
+    grep -vF "\"run\":\"$run\"" | tail -n 1 |
+    sed 's/.*"seconds":\([0-9.]*\).*/\1/'
+}
+
+for n in $search_lengths; do
+  for p in A B; do
+    best=
+    i=0
+    while [ $i -lt $reps ]; do
+      s=$(timed "$bin/$p" -j1 -o "$tmp/$p" $n)
+      best=$(awk -v a="$s" -v b="$best" 'BEGIN{print (b=="" || a<b) ? a : b}')
+      i=$((i+1))
+    done
+    prev=$(previous "$p-j1" $n)
+    emit "$p-j1" $n $best ",\"reps\":$reps,\"strings\":$(wc -l < "$tmp/$p")"
+    if [ -n "$prev" ]; then
+      echo "length $n: $p -j1 $best s, previous run $prev s" \
+        "($(awk -v a="$best" -v b="$prev" 'BEGIN{printf "%+.1f%%", 100*(a-b)/b}'))"
+    else
+      echo "length $n: $p -j1 $best s"
+    fi
+  done
+done
+
+echo "results appended to $results"
+exit $status
@@ -0,0 +1,67 @@
+/**
+ * @file bin2txt.c
+ *
+ * @brief Convert binary records of <b><tt>A -b</tt></b>, <b><tt>B -b</tt></b>
+ * and <b><tt>U -b</tt></b> to the text format.
+ *
+ * Executable usage: <b><tt>./bin2txt [<in_file>] 1> <out_file></tt></b> <br>
+ * - <b><tt><in_file></tt></b> is a binary record file (see BINRECORD). The
+ * records are read from stdin if no file is given.
+ * - Every record is written to stdout as the line the search would have printed
+ * without <b><tt>-b</tt></b>. Concatenated files (e.g. shards) are read
+ * through.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <output.h>
+
+/**
+ * @brief driver
+ * @param[in] in_file binary record file (default: stdin)
+ */
+int main(int argc, char **argv)
+{
+  FILE *fp=stdin;
+  char kind;
+  unsigned n, m, nc;
+  size_t i, nb, len;
+  int c;
+
+  if (argc>2) error(1, 0, "usage -- %s [<in_file>]", argv[0]);
+  if (argc==2 && (fp=fopen(argv[1],"rb"))==NULL)
+    error(1, errno, "failed to open %s", argv[1]);
+  if (!Binheaderread(fp,&kind,&n))
+    error(1, 0, "not a binary record file");
+
+  nb=(n+3)/4;
+  nc=BINCORRS(kind,n);
+  len=BINRECORD(n,nc);
+  unsigned char rec[len];
+  for (;;) {
+    while ( (c=getc(fp))==BINMAGIC[0] ) { /* header of a concatenated file */
+      ungetc(c,fp);
+      if (!Binheaderread(fp,&kind,&m) || m!=n || BINCORRS(kind,m)!=nc)
+        error(1, 0, "malformed binary header");
+    }
+    if (c==EOF) break;
+    ungetc(c,fp);
+    if (fread(rec,1,len,fp)!=len) break;
+    for (i=0; i<n; i++) putchar('0'+((rec[1+(i>>2U)]>>(2*(i&3U)))&3U));
+    putchar(' ');
+    for (i=0; i<nc; i++)
+      printf(i+1<nc ? "%d," : "%d\n",(int)(signed char)rec[1+nb+i]);
+  }
+  if (ferror(fp)) error(1, errno, "fread failed");
+  if (fp!=stdin) fclose(fp);
+  exit(0);
+}
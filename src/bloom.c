@@ -0,0 +1,190 @@
+/**
+ * @file bloom.c
+ * @brief Bloom filter of correlation vectors.
+ *
+ * A compact set of the correlation vectors of one side, used to drop strings
+ * of the other side that cannot have a partner before they are written. A
+ * vector that was added always tests positive; one that was not tests positive
+ * with a probability close to the false positive rate the filter was sized
+ * for. The k bit positions of a vector are derived from one 64-bit hash by
+ * double hashing.
+ *
+ * Filter files start with a header of BLOOMHEADER bytes: BLOOMMAGIC, the
+ * string length as a 16 bit little endian integer, the number of hashes and
+ * the base 2 logarithm of the number of bits. The bits follow, bit i in bit
+ * i%8 of byte i/8.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+# include <math.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <bloom.h>
+
+# define MINLOG 6  ///< base 2 logarithm of the smallest number of bits
+# define MAXLOG 40 ///< base 2 logarithm of the largest number of bits
+# define MAXK 16   ///< largest number of hashes
+
+/** @cond */
+
+struct bloom {
+  unsigned n, l;
+  unsigned k;      /* number of hashes */
+  unsigned lg;     /* base 2 logarithm of the number of bits */
+  uint64_t mask;   /* number of bits less one */
+  uint8_t *bits;
+};
+
+static inline
+uint64_t bloomhash(const signed char *key, unsigned l)
+{
+  uint64_t h=UINT64_C(14695981039346656037); /* FNV-1a */
+  for (unsigned i=0; i<l; i++) {
+    h^=(unsigned char)key[i];
+    h*=UINT64_C(1099511628211);
+  }
+  h^=h>>33U; /* finalizer of MurmurHash3 */
+  h*=UINT64_C(0xff51afd7ed558ccd);
+  h^=h>>33U;
+  return h;
+}
+
+static
+bloom_t *bloomalloc(unsigned n, unsigned k, unsigned lg)
+{
+  bloom_t *F=(bloom_t*)malloc(sizeof(bloom_t));
+  F->n=n;
+  F->l=n/2;
+  F->k=k;
+  F->lg=lg;
+  F->mask=(UINT64_C(1)<<lg)-1;
+  if ( (F->bits=(uint8_t*)calloc((size_t)1<<(lg-3),1))==NULL )
+    error(1, errno, "Bloominit -- calloc failed");
+  return F;
+}
+
+/** @endcond */
+
+/**
+ * @brief Create an empty filter.
+ *
+ * @param[in] n string length
+ * @param[in] nkeys number of vectors to be added
+ * @param[in] rate false positive rate aimed for (0 < rate < 1)
+ *
+ * @retval filter Return the filter (free with Bloomfree).
+ */
+bloom_t *Bloominit(unsigned n, size_t nkeys, double rate)
+{
+  double bits=-(double)(nkeys>0 ? nkeys : 1)*log(rate)/(M_LN2*M_LN2);
+  unsigned lg=MINLOG, k;
+
+  while (lg<MAXLOG && (double)(UINT64_C(1)<<lg)<bits) lg++;
+  k=(unsigned)lround((double)(UINT64_C(1)<<lg)/(nkeys>0 ? nkeys : 1)*M_LN2);
+  if (k<1) k=1;
+  if (k>MAXK) k=MAXK;
+  return bloomalloc(n,k,lg);
+}
+
+/**
+ * @brief Add a correlation vector.
+ * @param[in,out] F filter
+ * @param[in] key the n/2 correlations
+ */
+void Bloomadd(bloom_t *F, const signed char *key)
+{
+  uint64_t h=bloomhash(key,F->l), d=(h>>32U|h<<32U)|1U, b;
+  for (unsigned i=0; i<F->k; i++, h+=d) {
+    b=h&F->mask;
+    F->bits[b>>3U]=(uint8_t)(F->bits[b>>3U]|1U<<(b&7U));
+  }
+}
+
+/**
+ * @brief Test a correlation vector.
+ *
+ * @param[in] F filter
+ * @param[in] key the n/2 correlations
+ *
+ * @retval maybe Return false if the vector was not added, true if it may have
+ * been.
+ */
+bool Bloomtest(const bloom_t *F, const signed char *key)
+{
+  uint64_t h=bloomhash(key,F->l), d=(h>>32U|h<<32U)|1U, b;
+  for (unsigned i=0; i<F->k; i++, h+=d) {
+    b=h&F->mask;
+    if (!(F->bits[b>>3U]>>(b&7U)&1U)) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief String length of a filter.
+ * @param[in] F filter
+ * @retval n Return the string length.
+ */
+unsigned Bloomlength(const bloom_t *F)
+{
+  return F->n;
+}
+
+/**
+ * @brief Write a filter file.
+ * @param[in] F filter
+ * @param[in,out] fp output stream
+ */
+void Bloomwrite(const bloom_t *F, FILE *fp)
+{
+  unsigned char hdr[BLOOMHEADER]={BLOOMMAGIC[0],BLOOMMAGIC[1],BLOOMMAGIC[2],
+                                  BLOOMMAGIC[3],(unsigned char)(F->n&0xffU),
+                                  (unsigned char)(F->n>>8U),
+                                  (unsigned char)F->k,(unsigned char)F->lg};
+  size_t size=(size_t)1<<(F->lg-3);
+  if (fwrite(hdr,1,BLOOMHEADER,fp)!=BLOOMHEADER || fwrite(F->bits,1,size,fp)!=size)
+    error(1, errno, "fwrite failed");
+}
+
+/**
+ * @brief Read a filter file.
+ * @param[in] file filter file
+ * @retval filter Return the filter (free with Bloomfree).
+ */
+bloom_t *Bloomread(const char *file)
+{
+  unsigned char hdr[BLOOMHEADER];
+  unsigned n;
+  bloom_t *F;
+  FILE *fp;
+
+  if ( (fp=fopen(file,"rb"))==NULL ) error(1, errno, "failed to open %s", file);
+  if (fread(hdr,1,BLOOMHEADER,fp)!=BLOOMHEADER || memcmp(hdr,BLOOMMAGIC,4)!=0
+      || hdr[6]<1 || hdr[6]>MAXK || hdr[7]<MINLOG || hdr[7]>MAXLOG)
+    error(1, 0, "%s -- not a filter file", file);
+  n=hdr[4]|((unsigned)hdr[5]<<8U);
+  F=bloomalloc(n,hdr[6],hdr[7]);
+  if (fread(F->bits,1,(size_t)1<<(F->lg-3),fp)!=(size_t)1<<(F->lg-3))
+    error(1, 0, "%s -- truncated filter file", file);
+  fclose(fp);
+  return F;
+}
+
+/**
+ * @brief Free a filter.
+ * @param[in,out] F filter
+ */
+void Bloomfree(bloom_t *F)
+{
+  free(F->bits);
+  free(F);
+}
@@ -0,0 +1,28 @@
+/**
+ * @file bloom.h
+ * @brief Bloom filter of correlation vectors declarations.
+ * @author Thomas Pender
+ */
+# ifndef BLOOM_H
+# define BLOOM_H
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdbool.h>
+
+# define BLOOMMAGIC "LPQF" ///< magic of filter files
+# define BLOOMHEADER 8     ///< size of the header of filter files
+
+/** @brief Bloom filter of correlation vectors (see bloom.c). */
+typedef struct bloom bloom_t;
+
+bloom_t *Bloominit(unsigned, size_t, double);
+void Bloomadd(bloom_t*, const signed char*);
+bool Bloomtest(const bloom_t*, const signed char*);
+unsigned Bloomlength(const bloom_t*);
+void Bloomwrite(const bloom_t*, FILE*);
+bloom_t *Bloomread(const char*);
+void Bloomfree(bloom_t*);
+
+# endif
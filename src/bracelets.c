@@ -9,6 +9,10 @@
 # include <stdio.h>
 # include <stddef.h>
 # include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+# include <error.h>
+# include <errno.h>
 
 /* project headers */
 # include <defs.h>
@@ -27,13 +31,19 @@ typedef struct {
 } cell_t;
 
 static inline
-cell_t *cellinit(unsigned k)
+void cellreset(cell_t *avail, unsigned k)
 {
-  cell_t *avail=(cell_t*)malloc((k+2)*sizeof(cell_t));
   for (int j=(int)k+1; j>=0; j--) {
     avail[j].next=j-1;
     avail[j].prev=j+1;
   }
+}
+
+static inline
+cell_t *cellinit(unsigned k)
+{
+  cell_t *avail=(cell_t*)malloc((k+2)*sizeof(cell_t));
+  cellreset(avail,k);
   return avail;
 }
 
@@ -73,7 +83,19 @@ void strprintstd(const unsigned *a, const neck_t *N)
 {
   for (size_t i=1; i<=N->n; i++) printf("%u",a[i]-1);
   printf("\n");
-  fflush(stdout);
+}
+
+static inline
+bool argpush(neck_t *N, const unsigned *a, unsigned t, void *args)
+{
+  N->nodes++;
+  return N->argpush==NULL || N->argpush(a,t,args);
+}
+
+static inline
+void argpop(neck_t *N, const unsigned *a, unsigned t, void *args)
+{
+  if (N->argpop!=NULL) N->argpop(a,t,args);
 }
 
 static
@@ -91,17 +113,18 @@ void strprint(const unsigned *a, const neck_t *N, void *args
         break;
   }
   if (flag) {
+    if (N->seqprint!=NULL) N->seqprint(a,args); /* buffers of its own */
+    else {
 # if HAVE_PTHREAD
-    if (mtx!=NULL) pthread_mutex_lock(mtx);
+      if (mtx!=NULL) pthread_mutex_lock(mtx);
 # endif
-    if (N->seqprint==NULL) strprintstd(a,N);
-    else N->seqprint(a,args);
+      strprintstd(a,N);
 # if HAVE_PTHREAD
-    if (mtx!=NULL) pthread_mutex_unlock(mtx);
+      if (mtx!=NULL) pthread_mutex_unlock(mtx);
 # endif
+    }
   }
   if (N->argfree!=NULL) N->argfree(args);
-  fflush(stdout);
 }
 
 /* necklaces with fixed content */
@@ -119,6 +142,12 @@ void FCNecklace_in(unsigned t, unsigned p, unsigned s,
   int j;
   unsigned s2;
 
+  if (N->split!=NULL && (t-1==N->depth || N->num[N->k]==N->n-t+1)) {
+    node_t node={.t=t,.p=p,.z=s,.a=a,.run=run,.num=N->num};
+    N->split(&node,N->splitarg);
+    return;
+  }
+
   if (N->num[N->k] == N->n-t+1) {
     if ((N->num[N->k]==run[t-p]) && (N->n%p == 0)) strprint(a,N,args
 # if HAVE_PTHREAD
@@ -142,18 +171,21 @@ void FCNecklace_in(unsigned t, unsigned p, unsigned s,
       if (N->num[j]==0) cellremove(avail,j,head);
 
       if (j!=(int)(N->k))  s2=t+1;
-      if (j==(int)a[t-p])
-        FCNecklace_in(t+1,p,s2,N,a,run,avail,head,args
+      if (argpush(N,a,t,args)) {
+        if (j==(int)a[t-p])
+          FCNecklace_in(t+1,p,s2,N,a,run,avail,head,args
 # if HAVE_PTHREAD
-                      ,mtx
+                        ,mtx
 # endif
-                      );
-      else
-        FCNecklace_in(t+1,t,s2,N,a,run,avail,head,args
+                        );
+        else
+          FCNecklace_in(t+1,t,s2,N,a,run,avail,head,args
 # if HAVE_PTHREAD
-                      ,mtx
+                        ,mtx
 # endif
-                      );
+                        );
+      }
+      argpop(N,a,t,args);
 
       if (N->num[j]==0) celladd(avail,N->k,j,head);
       N->num[j]++;
@@ -171,7 +203,13 @@ void FCNecklace_in(unsigned t, unsigned p, unsigned s,
  *
  * Generates fixed content quaternary necklaces. The user includes boolean checks,
  * memory allocation and deallocation methods, and printing methods. These are
- * called for every generated necklace.
+ * called for every generated necklace. If provided, <b><tt>N->argpush</tt></b>
+ * is called for every fixed string position and the subtree below is skipped
+ * when it returns false.
+ *
+ * If <b><tt>N->split</tt></b> is set, the recursion stops at prefix length
+ * <b><tt>N->depth</tt></b> and each node there, as well as each leaf above it,
+ * is handed to <b><tt>N->split</tt></b> instead (see FCNecklacesub).
  *
  * @param[in] N string length
  * @param[in] args user provided methods to be called on generated necklaces
@@ -189,12 +227,15 @@ void FCNecklace(neck_t *N, void *args
   cell_t *avail=cellinit(N->k);
 
   N->num[1]--;
-  if (N->num[1]==0) cellremove(avail,1,&head);
-  FCNecklace_in(2,1,2,N,a,run,avail,&head,args
+  for (int i=(int)N->k; i>=1; i--) /* letters of no content */
+    if (N->num[i]==0) cellremove(avail,i,&head);
+  if (argpush(N,a,1,args))
+    FCNecklace_in(2,1,2,N,a,run,avail,&head,args
 # if HAVE_PTHREAD
-                ,mtx
+                  ,mtx
 # endif
-                );
+                  );
+  argpop(N,a,1,args);
 
   free(avail);
   free(run);
@@ -205,10 +246,6 @@ void FCNecklace(neck_t *N, void *args
 
 /** @cond */
 
-typedef struct {
-  unsigned s, v;
-} elem_t;
-
 typedef struct {
   unsigned nb;
   elem_t *elems;
@@ -247,6 +284,29 @@ void blockfree(block_t *B)
   if (B->elems!=NULL) free(B->elems);
 }
 
+/* arrays of FCBraceletsub, in one block kept by the structure (N->work) */
+typedef struct {
+  block_t B;
+  unsigned *a, *run;
+  cell_t *avail;
+} work_t;
+
+static
+work_t *workget(neck_t *N)
+{
+  size_t n=N->n+1;
+  work_t *W=(work_t*)N->work;
+  if (W!=NULL) return W;
+  W=(work_t*)malloc(sizeof(work_t)+n*sizeof(elem_t)+2*n*sizeof(unsigned)
+                    +(N->k+2)*sizeof(cell_t));
+  W->B.elems=(elem_t*)(W+1);
+  W->a=(unsigned*)(W->B.elems+n);
+  W->run=W->a+n;
+  W->avail=(cell_t*)(W->run+n);
+  N->work=W;
+  return W;
+}
+
 static
 int checkrev(block_t *B)
 {
@@ -278,6 +338,13 @@ void FCBracelet_in(unsigned t, unsigned p, unsigned r,
   int j,c;
   unsigned z2,p2;
 
+  if (N->split!=NULL && (t-1==N->depth || N->num[N->k]==N->n-t+1)) {
+    node_t node={.t=t,.p=p,.r=r,.z=z,.b=b,.RS=RS,.nb=B->nb,
+                 .a=a,.run=run,.num=N->num,.elems=B->elems};
+    N->split(&node,N->splitarg);
+    return;
+  }
+
   if (t-1>(N->n-r)/2+r) {
     if (a[t-1]>a[N->n-t+2+r]) RS=false;
     else if (a[t-1]<a[N->n-t+2+r]) RS=true;
@@ -311,18 +378,23 @@ void FCBracelet_in(unsigned t, unsigned p, unsigned r,
       p2=p;
       if (j!=(int)a[t-p]) p2=t;
       c=checkrev(B);
-      if (c==0) FCBracelet_in(t+1,p2,t,z2,B->nb,false,
-                              N,args,a,run,avail,head,B
+      if (c!=-1) {
+        if (argpush(N,a,t,args)) {
+          if (c==0) FCBracelet_in(t+1,p2,t,z2,B->nb,false,
+                                  N,args,a,run,avail,head,B
 # if HAVE_PTHREAD
-                              ,mtx
+                                  ,mtx
 # endif
-                              );
-      if (c==1) FCBracelet_in(t+1,p2,r,z2,b,RS,
-                              N,args,a,run,avail,head,B
+                                  );
+          else FCBracelet_in(t+1,p2,r,z2,b,RS,
+                             N,args,a,run,avail,head,B
 # if HAVE_PTHREAD
-                              ,mtx
+                             ,mtx
 # endif
-                              );
+                             );
+        }
+        argpop(N,a,t,args);
+      }
       if (N->num[j]==0) celladd(avail,N->k,j,head);
       N->num[j]++;
       restorerunlength(B);
@@ -332,6 +404,116 @@ void FCBracelet_in(unsigned t, unsigned p, unsigned r,
   }
 }
 
+/* binary bracelets with fixed content */
+
+/*
+ * Strings of two letters are held in a machine word, position i in bit n-i,
+ * so that strings compare as their words do. The necklaces are generated by
+ * the FKM recursion (a[t]>=a[t-p]) bounded by the content, and a necklace is
+ * a bracelet if no rotation of its reversal is less.
+ */
+
+typedef struct {
+  neck_t *N;
+  void *args;
+  unsigned *a;
+  unsigned w;     /* number of letters 2 */
+  uint64_t mask;
+# if HAVE_PTHREAD
+  pthread_mutex_t *mtx;
+# endif
+} binary_t;
+
+static inline
+uint64_t wordreverse(uint64_t x, unsigned n)
+{
+  x=((x>>1U)&UINT64_C(0x5555555555555555))|((x&UINT64_C(0x5555555555555555))<<1U);
+  x=((x>>2U)&UINT64_C(0x3333333333333333))|((x&UINT64_C(0x3333333333333333))<<2U);
+  x=((x>>4U)&UINT64_C(0x0f0f0f0f0f0f0f0f))|((x&UINT64_C(0x0f0f0f0f0f0f0f0f))<<4U);
+  return __builtin_bswap64(x)>>(64-n);
+}
+
+/* whether the necklace x is the least string of its bracelet */
+static inline
+bool wordbracelet(uint64_t x, unsigned n, uint64_t mask)
+{
+  const uint64_t r=wordreverse(x,n);
+  if (r<x) return false;
+  for (unsigned s=1; s<n; s++)
+    if ((((r<<s)|(r>>(n-s)))&mask)<x) return false;
+  return true;
+}
+
+static
+void FCBinary_in(unsigned t, unsigned p, uint64_t x, unsigned ones,
+                 binary_t *W)
+{
+  neck_t *N=W->N;
+  const unsigned n=N->n, zeros=t-1-ones;
+  uint64_t bit;
+
+  if (t>n) {
+    if (n%p==0 && wordbracelet(x,n,W->mask)) strprint(W->a,N,W->args
+# if HAVE_PTHREAD
+                                                      ,W->mtx
+# endif
+                                                      );
+    return;
+  }
+  bit=(uint64_t)1<<(n-t);
+  if (((x>>(n-t+p))&1U)==0) { /* a[t-p]==1 */
+    if (zeros<n-W->w) {
+      W->a[t]=1;
+      if (argpush(N,W->a,t,W->args)) FCBinary_in(t+1,p,x,ones,W);
+      argpop(N,W->a,t,W->args);
+    }
+    if (ones<W->w) {
+      W->a[t]=2;
+      if (argpush(N,W->a,t,W->args)) FCBinary_in(t+1,t,x|bit,ones+1,W);
+      argpop(N,W->a,t,W->args);
+    }
+  }
+  else if (ones<W->w) {
+    W->a[t]=2;
+    if (argpush(N,W->a,t,W->args)) FCBinary_in(t+1,p,x|bit,ones+1,W);
+    argpop(N,W->a,t,W->args);
+  }
+  W->a[t]=N->k;
+}
+
+/* continues below prefix a[1..t-1] of necklace parameter p */
+static
+void FCBinary(neck_t *N, unsigned *a, unsigned t, unsigned p, void *args
+# if HAVE_PTHREAD
+              ,pthread_mutex_t *mtx
+# endif
+              )
+{
+  binary_t W={.N=N,.args=args,.a=a,.w=N->num[2],
+              .mask=N->n>=64 ? ~(uint64_t)0 : ((uint64_t)1<<N->n)-1
+# if HAVE_PTHREAD
+              ,.mtx=mtx
+# endif
+  };
+  uint64_t x=0;
+  unsigned ones=0;
+
+  for (unsigned i=1; i<t; i++)
+    if (a[i]==2) {
+      x|=(uint64_t)1<<(N->n-i);
+      ones++;
+    }
+  W.w+=ones;
+  FCBinary_in(t,p,x,ones,&W);
+}
+
+/* whether the strings of a structure are enumerated by FCBinary */
+static inline
+bool binary(const neck_t *N)
+{
+  return N->k==2 && N->n<=64;
+}
+
 /** @endcond */
 
 /**
@@ -339,7 +521,16 @@ void FCBracelet_in(unsigned t, unsigned p, unsigned r,
  *
  * Generates fixed content quaternary bracelets. The user includes boolean checks,
  * memory allocation and deallocation methods, and printing methods. These are
- * called for every generated bracelet.
+ * called for every generated bracelet. If provided, <b><tt>N->argpush</tt></b>
+ * is called for every fixed string position and the subtree below is skipped
+ * when it returns false.
+ *
+ * If <b><tt>N->split</tt></b> is set, the recursion stops at prefix length
+ * <b><tt>N->depth</tt></b> and each node there, as well as each leaf above it,
+ * is handed to <b><tt>N->split</tt></b> instead (see FCBraceletsub).
+ *
+ * Bracelets of two letters and length at most 64 are generated on machine
+ * words, with the same calls.
  *
  * @param[in] N string length
  * @param[in] args user provided methods to be called on generated bracelet
@@ -359,12 +550,23 @@ void FCBracelet(neck_t *N, void *args
   updaterunlength(1,B);
 
   N->num[1]--;
-  if (N->num[1]==0) cellremove(avail,1,&head);
-  FCBracelet_in(2,1,1,2,1,false,N,args,a,run,avail,&head,B
+  for (int i=(int)N->k; i>=1; i--) /* letters of no content */
+    if (N->num[i]==0) cellremove(avail,i,&head);
+  if (argpush(N,a,1,args)) {
+    if (N->split==NULL && binary(N))
+      FCBinary(N,a,2,1,args
 # if HAVE_PTHREAD
-                ,mtx
+               ,mtx
 # endif
-                );
+               );
+    else
+      FCBracelet_in(2,1,1,2,1,false,N,args,a,run,avail,&head,B
+# if HAVE_PTHREAD
+                    ,mtx
+# endif
+                    );
+  }
+  argpop(N,a,1,args);
 
   blockfree(B);
   free(B);
@@ -372,3 +574,623 @@ void FCBracelet(neck_t *N, void *args
   free(run);
   free(a);
 }
+
+/**
+ * @brief Generate fixed content bracelets below a node of the recursion.
+ *
+ * Continues the recursion of FCBracelet from a node previously handed to
+ * <b><tt>N->split</tt></b>. The content <b><tt>N->num</tt></b> is overwritten
+ * by that of the node. The arrays of the recursion are allocated by the first
+ * call on <b><tt>N</tt></b> and kept for the next ones (see Neckfree).
+ *
+ * @param[in] N string length
+ * @param[in] node node of the recursion (see node_t)
+ * @param[in] args user provided methods to be called on generated bracelet
+ * @param[in,out] mtx dynamic mtx guarding stdout
+ */
+void FCBraceletsub(neck_t *N, const node_t *node, void *args
+# if HAVE_PTHREAD
+                   ,pthread_mutex_t *mtx
+# endif
+                   )
+{
+  size_t i;
+  int head=(int)N->k;
+  work_t *W=workget(N);
+  unsigned *a=W->a, *run=W->run;
+  cell_t *avail=W->avail;
+  block_t *B=&W->B;
+
+  cellreset(avail,N->k);
+  for (i=0; i<=N->n; i++) {
+    a[i]=node->a[i];
+    run[i]=node->run[i];
+    B->elems[i]=node->elems[i];
+  }
+  B->nb=node->nb;
+  for (i=0; i<=N->k; i++) N->num[i]=node->num[i];
+  for (i=N->k; i>=1; i--)
+    if (N->num[i]==0) cellremove(avail,(int)i,&head);
+
+  for (i=1; i<node->t; i++) argpush(N,a,(unsigned)i,args);
+  if (N->split==NULL && binary(N))
+    FCBinary(N,a,node->t,node->p,args
+# if HAVE_PTHREAD
+             ,mtx
+# endif
+             );
+  else
+    FCBracelet_in(node->t,node->p,node->r,node->z,node->b,node->RS,
+                  N,args,a,run,avail,&head,B
+# if HAVE_PTHREAD
+                  ,mtx
+# endif
+                  );
+  for (i=node->t-1; i>=1; i--) argpop(N,a,(unsigned)i,args);
+}
+
+/**
+ * @brief Generate fixed content necklaces below a node of the recursion.
+ *
+ * Continues the recursion of FCNecklace from a node previously handed to
+ * <b><tt>N->split</tt></b>, as FCBraceletsub does for FCBracelet.
+ *
+ * @param[in] N string length
+ * @param[in] node node of the recursion (see node_t)
+ * @param[in] args user provided methods to be called on generated necklaces
+ * @param[in,out] mtx dynamic mtx guarding stdout
+ */
+void FCNecklacesub(neck_t *N, const node_t *node, void *args
+# if HAVE_PTHREAD
+                   ,pthread_mutex_t *mtx
+# endif
+                   )
+{
+  size_t i;
+  int head=(int)N->k;
+  work_t *W=workget(N);
+  unsigned *a=W->a, *run=W->run;
+  cell_t *avail=W->avail;
+
+  cellreset(avail,N->k);
+  for (i=0; i<=N->n; i++) {
+    a[i]=node->a[i];
+    run[i]=node->run[i];
+  }
+  for (i=0; i<=N->k; i++) N->num[i]=node->num[i];
+  for (i=N->k; i>=1; i--)
+    if (N->num[i]==0) cellremove(avail,(int)i,&head);
+
+  for (i=1; i<node->t; i++) argpush(N,a,(unsigned)i,args);
+  FCNecklace_in(node->t,node->p,node->z,N,a,run,avail,&head,args
+# if HAVE_PTHREAD
+                ,mtx
+# endif
+                );
+  for (i=node->t-1; i>=1; i--) argpop(N,a,(unsigned)i,args);
+}
+
+/**
+ * @brief Copy a node of the bracelet recursion.
+ *
+ * @param[in] node node handed to <b><tt>N->split</tt></b>
+ * @param[in] N string length
+ *
+ * @retval copy Return a copy owning its arrays (free with Nodefree).
+ */
+node_t *Nodecopy(const node_t *node, const neck_t *N)
+{
+  size_t i;
+  node_t *c=(node_t*)malloc(sizeof(node_t));
+  *c=*node;
+  c->a=(unsigned*)malloc((2*(N->n+1)+N->k+1)*sizeof(unsigned));
+  c->run=c->a+N->n+1;
+  c->num=c->run+N->n+1;
+  c->elems=(elem_t*)malloc((N->n+1)*sizeof(elem_t));
+  for (i=0; i<=N->n; i++) {
+    c->a[i]=node->a[i];
+    c->run[i]=node->run[i];
+    c->elems[i]=node->elems!=NULL ? node->elems[i] : (elem_t){0};
+  }
+  for (i=0; i<=N->k; i++) c->num[i]=node->num[i];
+  return c;
+}
+
+/**
+ * @brief Free a node returned by Nodecopy.
+ */
+void Nodefree(node_t *node)
+{
+  if (node==NULL) return;
+  free(node->a);
+  free(node->elems);
+  free(node);
+}
+
+/**
+ * @brief Number of arrangements of the content left to place below a node.
+ *
+ * The multinomial coefficient of the remaining content, an upper bound on
+ * the number of strings below the node and an estimate of the cost of its
+ * subtree. Computed in the same order everywhere, so the result is the same
+ * on every machine.
+ *
+ * @param[in] node node handed to <b><tt>N->split</tt></b>
+ * @param[in] k string arity
+ *
+ * @retval count Return the number of arrangements.
+ */
+double Nodearrangements(const node_t *node, unsigned k)
+{
+  double c=1;
+  unsigned m=0, i, j;
+  for (j=1; j<=k; j++)
+    for (i=1; i<=node->num[j]; i++) c=c*++m/i;
+  return c;
+}
+
+/* iterative generation */
+
+/** @cond */
+
+/*
+ * Frame of the explicit stack, one per prefix length: the parameters of the
+ * call of FCBracelet_in (FCNecklace_in: s in z and s2 in b) and the letter
+ * placed at position t.
+ */
+typedef struct {
+  unsigned t, p, r, z, b;
+  bool RS;
+  int j;
+} frame_t;
+
+struct iter {
+  neck_t *N;
+  void *args;
+  bool bracelet;  /* bracelets or necklaces */
+  unsigned base;  /* level of the first frame; positions below were pushed once */
+  unsigned top;   /* level of the current frame, base-1 when done */
+  bool enter;     /* current frame not entered yet (else its child returned) */
+  bool yielded;   /* a string was returned (argfree pending) */
+  int head;
+  unsigned *a, *run;
+  cell_t *avail;
+  block_t B;
+  frame_t *F;     /* F[t]: frame of level t */
+};
+
+static
+iter_t *iteralloc(neck_t *N, void *args, bool bracelet)
+{
+  size_t n=N->n+1;
+  iter_t *I=(iter_t*)malloc(sizeof(iter_t)+(n+1)*sizeof(frame_t)
+                            +n*sizeof(elem_t)+2*n*sizeof(unsigned)
+                            +(N->k+2)*sizeof(cell_t));
+  if (I==NULL) error(1, errno, "malloc failed");
+  I->F=(frame_t*)(I+1);
+  I->B.elems=(elem_t*)(I->F+n+1);
+  I->a=(unsigned*)(I->B.elems+n);
+  I->run=I->a+n;
+  I->avail=(cell_t*)(I->run+n);
+  I->B.nb=0; memset(I->B.elems,0,n*sizeof(elem_t)); /* no block yet */
+  I->N=N;
+  I->args=args;
+  I->bracelet=bracelet;
+  I->yielded=false;
+  I->enter=true;
+  return I;
+}
+
+/* available letters of the content N->num */
+static
+void iteravail(iter_t *I)
+{
+  I->head=(int)I->N->k;
+  cellreset(I->avail,I->N->k);
+  for (unsigned i=I->N->k; i>=1; i--)
+    if (I->N->num[i]==0) cellremove(I->avail,(int)i,&I->head);
+}
+
+/* number of positions pushed (see argpush) */
+static inline
+unsigned iterpushed(const iter_t *I)
+{
+  return I->enter ? I->top-1 : I->top;
+}
+
+/* place letter F->j at position F->t */
+static inline
+void iterplace(iter_t *I, frame_t *F)
+{
+  neck_t *N=I->N;
+  const int j=F->j;
+  I->run[F->z]=F->t-F->z;
+  if (I->bracelet) updaterunlength((unsigned)j,&I->B);
+  N->num[j]--;
+  if (N->num[j]==0) cellremove(I->avail,j,&I->head);
+  I->a[F->t]=(unsigned)j;
+}
+
+/* undo of iterplace */
+static inline
+void iterunplace(iter_t *I, const frame_t *F)
+{
+  neck_t *N=I->N;
+  if (N->num[F->j]==0) celladd(I->avail,N->k,F->j,&I->head);
+  N->num[F->j]++;
+  if (I->bracelet) restorerunlength(&I->B);
+}
+
+/* return from the current frame; pops the positions below the first one */
+static inline
+void iterup(iter_t *I)
+{
+  I->enter=false;
+  if (--I->top<I->base)
+    for (unsigned i=I->base-1; i>=1; i--) argpop(I->N,I->a,i,I->args);
+}
+
+static void iterloop(iter_t*, frame_t*, bool);
+
+/* enter the current frame; returns whether it is a leaf to be printed */
+static
+bool iterenter(iter_t *I, frame_t *F)
+{
+  neck_t *N=I->N;
+  const unsigned n=N->n, k=N->k, t=F->t;
+  unsigned *a=I->a;
+  bool leaf=false;
+
+  if (I->bracelet) {
+    if (t-1>(n-F->r)/2+F->r) {
+      if (a[t-1]>a[n-t+2+F->r]) F->RS=false;
+      else if (a[t-1]<a[n-t+2+F->r]) F->RS=true;
+    }
+    if (N->num[k]==n-t+1) {
+      if (N->num[k]>I->run[t-F->p]) F->p=n;
+      if (N->num[k]>0 && t!=F->r+1 && I->B.elems[F->b+1].s==k
+          && I->B.elems[F->b+1].v>N->num[k])
+        F->RS=true;
+      if (N->num[k]>0 && t!=F->r+1 && (I->B.elems[F->b+1].s!=k
+                                       || I->B.elems[F->b+1].v<N->num[k]))
+        F->RS=false;
+      leaf=F->RS==false && n%F->p==0;
+      iterup(I);
+      return leaf;
+    }
+  }
+  else if (N->num[k]==n-t+1) {
+    leaf=(N->num[k]==I->run[t-F->p] && n%F->p==0) || N->num[k]>I->run[t-F->p];
+    iterup(I);
+    return leaf;
+  }
+  if (N->num[1]==n-t+1) {
+    iterup(I);
+    return false;
+  }
+  F->j=I->head;
+  if (!I->bracelet) F->b=F->z;
+  iterloop(I,F,false);
+  return false;
+}
+
+/*
+ * continue the loop over the letters of the current frame, its previous
+ * letter being placed when more is set; descends into the next child
+ */
+static
+void iterloop(iter_t *I, frame_t *F, bool more)
+{
+  neck_t *N=I->N;
+  const unsigned t=F->t;
+  unsigned *a=I->a, z2, p2;
+  frame_t *C=F+1;
+  int c;
+
+  if (more) {
+    argpop(N,a,t,I->args);
+    iterunplace(I,F);
+    F->j=I->avail[F->j].next;
+  }
+  while (F->j>=(int)a[t-F->p]) {
+    iterplace(I,F);
+    if (I->bracelet) {
+      z2=F->j!=(int)N->k ? t+1 : F->z;
+      p2=F->j!=(int)a[t-F->p] ? t : F->p;
+      c=checkrev(&I->B);
+      if (c!=-1) {
+        if (argpush(N,a,t,I->args)) {
+          *C=c==0 ? (frame_t){.t=t+1,.p=p2,.r=t,.z=z2,.b=I->B.nb,.RS=false}
+            : (frame_t){.t=t+1,.p=p2,.r=F->r,.z=z2,.b=F->b,.RS=F->RS};
+          I->top=t+1;
+          I->enter=true;
+          return;
+        }
+        argpop(N,a,t,I->args);
+      }
+    }
+    else {
+      if (F->j!=(int)N->k) F->b=t+1;
+      if (argpush(N,a,t,I->args)) {
+        *C=(frame_t){.t=t+1,.p=F->j==(int)a[t-F->p] ? F->p : t,.z=F->b};
+        I->top=t+1;
+        I->enter=true;
+        return;
+      }
+      argpop(N,a,t,I->args);
+    }
+    iterunplace(I,F);
+    F->j=I->avail[F->j].next;
+  }
+  a[t]=N->k;
+  iterup(I);
+}
+
+/* advance to the next string the recursion would print, before the checks */
+static
+bool iterstep(iter_t *I)
+{
+  frame_t *F;
+  while (I->top>=I->base) {
+    F=I->F+I->top;
+    if (!I->enter) iterloop(I,F,true);
+    else if (iterenter(I,F)) return true;
+  }
+  return false;
+}
+
+/** @endcond */
+
+/**
+ * @brief Iterator over fixed content bracelets.
+ *
+ * The pull-style counterpart of FCBracelet and FCBraceletsub: instead of the
+ * recursion calling back into the checks and the printing method, the caller
+ * asks for the strings one at a time (see Iternext), with an explicit stack in
+ * place of the recursion. The methods of <b><tt>N</tt></b> are called as by
+ * the recursion, except <b><tt>N->seqprint</tt></b> and
+ * <b><tt>N->split</tt></b>, which are not used. The content
+ * <b><tt>N->num</tt></b> is worked on in place.
+ *
+ * @param[in,out] N string length
+ * @param[in] node node of the recursion (see FCBraceletsub), or NULL for the
+ * root
+ * @param[in,out] args user provided methods to be called on generated bracelets
+ *
+ * @retval iterator Return the iterator (free with Iterfree).
+ */
+iter_t *Braceletiter(neck_t *N, const node_t *node, void *args)
+{
+  iter_t *I=iteralloc(N,args,true);
+  size_t i;
+
+  if (node==NULL) {
+    for (i=0; i<=N->n; i++) {
+      I->a[i]=i<2 ? (unsigned)i : N->k;
+      I->run[i]=0;
+    }
+    for (i=0; i<=N->n; i++) I->B.elems[i]=(elem_t){0,0};
+    I->B.nb=0;
+    updaterunlength(1,&I->B);
+    N->num[1]--;
+    I->F[2]=(frame_t){.t=2,.p=1,.r=1,.z=2,.b=1,.RS=false};
+  }
+  else {
+    for (i=0; i<=N->n; i++) {
+      I->a[i]=node->a[i];
+      I->run[i]=node->run[i];
+      I->B.elems[i]=node->elems[i];
+    }
+    I->B.nb=node->nb;
+    for (i=0; i<=N->k; i++) N->num[i]=node->num[i];
+    I->F[node->t]=(frame_t){.t=node->t,.p=node->p,.r=node->r,.z=node->z,
+                            .b=node->b,.RS=node->RS};
+  }
+  iteravail(I);
+  I->base=I->top=node==NULL ? 2 : node->t;
+
+  if (node==NULL) {
+    if (!argpush(N,I->a,1,args)) iterup(I);
+  }
+  else
+    for (i=1; i<node->t; i++) argpush(N,I->a,(unsigned)i,args);
+  return I;
+}
+
+/**
+ * @brief Iterator over fixed content necklaces.
+ *
+ * The pull-style counterpart of FCNecklace (see Braceletiter).
+ *
+ * @param[in,out] N string length
+ * @param[in,out] args user provided methods to be called on generated necklaces
+ *
+ * @retval iterator Return the iterator (free with Iterfree).
+ */
+iter_t *Necklaceiter(neck_t *N, void *args)
+{
+  iter_t *I=iteralloc(N,args,false);
+
+  for (size_t i=0; i<=N->n; i++) {
+    I->a[i]=i<2 ? (unsigned)i : N->k;
+    I->run[i]=0;
+  }
+  N->num[1]--;
+  iteravail(I);
+  I->F[2]=(frame_t){.t=2,.p=1,.z=2};
+  I->base=I->top=2;
+  if (!argpush(N,I->a,1,args)) iterup(I);
+  return I;
+}
+
+/**
+ * @brief Next string passing the checks.
+ *
+ * Runs the recursion up to the next string passing the checks of
+ * <b><tt>N</tt></b> (after <b><tt>N->arginit</tt></b>), in the order the
+ * recursion would print them. The arguments hold the state of that string
+ * until the next call.
+ *
+ * @param[in,out] I iterator
+ *
+ * @retval string Return the string (entries 1..n, letters 1..k), valid until
+ * the next call, or NULL once all strings were returned.
+ */
+const unsigned *Iternext(iter_t *I)
+{
+  neck_t *N=I->N;
+  size_t i;
+
+  if (I->yielded && N->argfree!=NULL) N->argfree(I->args);
+  I->yielded=false;
+  while (iterstep(I)) {
+    if (N->arginit!=NULL) N->arginit(I->a,I->args);
+    for (i=0; i<N->ncheckfuncs; i++)
+      if (!N->checkfuncs[i](I->args)) break;
+    I->yielded=true;
+    if (i==N->ncheckfuncs) return I->a;
+    if (N->argfree!=NULL) N->argfree(I->args);
+    I->yielded=false;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Next strings passing the checks.
+ *
+ * Calls Iternext up to <b><tt>max</tt></b> times, string s being copied to
+ * entries <b><tt>s*n</tt></b> to <b><tt>s*n+n-1</tt></b> of
+ * <b><tt>strings</tt></b>.
+ *
+ * @param[in,out] I iterator
+ * @param[out] strings strings returned (letters 1..k)
+ * @param[in] max number of strings wanted
+ *
+ * @retval count Return the number of strings returned, less than
+ * <b><tt>max</tt></b> only once all strings were returned.
+ */
+size_t Iternextbatch(iter_t *I, unsigned *strings, size_t max)
+{
+  const unsigned n=I->N->n, *a;
+  size_t count=0;
+
+  while (count<max && (a=Iternext(I))!=NULL) {
+    for (unsigned i=0; i<n; i++) strings[count*n+i]=a[i+1];
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Save the state of an iterator.
+ *
+ * Written as text: ITERMAGIC, the kind ('B' or 'N'), the string length and
+ * arity, the levels of the first and current frames and whether the current
+ * one is yet to be entered, followed by the prefix, run and content arrays,
+ * the run-length blocks and the frames. The arguments are not saved; they are
+ * rebuilt from the prefix by Iterload.
+ *
+ * @param[in] I iterator
+ * @param[in,out] fp output stream
+ */
+void Itersave(const iter_t *I, FILE *fp)
+{
+  const neck_t *N=I->N;
+  size_t i;
+  unsigned t;
+
+  fprintf(fp,"%s %c %u %u %u %u %d\n",ITERMAGIC,I->bracelet ? 'B' : 'N',N->n,
+          N->k,I->base,I->top,(int)I->enter);
+  for (i=0; i<=N->n; i++) fprintf(fp,"%u%c",I->a[i],i<N->n ? ' ' : '\n');
+  for (i=0; i<=N->n; i++) fprintf(fp,"%u%c",I->run[i],i<N->n ? ' ' : '\n');
+  for (i=0; i<=N->k; i++) fprintf(fp,"%u%c",N->num[i],i<N->k ? ' ' : '\n');
+  fprintf(fp,"%u",I->B.nb);
+  for (i=0; i<=I->B.nb; i++)
+    fprintf(fp," %u %u",I->B.elems[i].s,I->B.elems[i].v);
+  fputc('\n',fp);
+  for (t=I->base; t<=I->top; t++)
+    fprintf(fp,"%u %u %u %u %u %d %d\n",I->F[t].t,I->F[t].p,I->F[t].r,
+            I->F[t].z,I->F[t].b,(int)I->F[t].RS,I->F[t].j);
+  if (ferror(fp)) error(1, errno, "failed to save the iterator");
+}
+
+/**
+ * @brief Restore an iterator saved by Itersave.
+ *
+ * The arguments are rebuilt by pushing the positions of the saved prefix (see
+ * argpush), so the next string returned is the one that followed the last
+ * string returned before saving.
+ *
+ * @param[in,out] fp input stream
+ * @param[in,out] N string length (same content class as the saved iterator)
+ * @param[in,out] args user provided methods to be called on generated strings
+ *
+ * @retval iterator Return the iterator (free with Iterfree).
+ */
+iter_t *Iterload(FILE *fp, neck_t *N, void *args)
+{
+  char magic[5], kind;
+  unsigned n, k, base, top, t;
+  int enter, RS;
+  size_t i;
+  iter_t *I;
+  bool ok;
+
+  if (fscanf(fp,"%4s %c %u %u %u %u %d",magic,&kind,&n,&k,&base,&top,
+             &enter)!=7 || strcmp(magic,ITERMAGIC)!=0
+      || (kind!='B' && kind!='N'))
+    error(1, 0, "not an iterator state");
+  if (n!=N->n || k!=N->k || base<2 || top+1<base || top>n+1)
+    error(1, 0, "iterator state of another search");
+  I=iteralloc(N,args,kind=='B');
+  I->base=base;
+  I->top=top;
+  I->enter=enter!=0;
+  ok=true;
+  for (i=0; i<=n; i++) ok=ok && fscanf(fp,"%u",I->a+i)==1;
+  for (i=0; i<=n; i++) ok=ok && fscanf(fp,"%u",I->run+i)==1;
+  for (i=0; i<=k; i++) ok=ok && fscanf(fp,"%u",N->num+i)==1;
+  ok=ok && fscanf(fp,"%u",&I->B.nb)==1 && I->B.nb<=n;
+  for (i=0; ok && i<=I->B.nb; i++)
+    ok=fscanf(fp,"%u %u",&I->B.elems[i].s,&I->B.elems[i].v)==2;
+  for (t=base; ok && t<=top; t++) {
+    ok=fscanf(fp,"%u %u %u %u %u %d %d",&I->F[t].t,&I->F[t].p,&I->F[t].r,
+              &I->F[t].z,&I->F[t].b,&RS,&I->F[t].j)==7 && I->F[t].t==t;
+    I->F[t].RS=RS!=0;
+  }
+  if (!ok) error(1, 0, "truncated iterator state");
+
+  /* letters removed in the order of the frames (see celladd) */
+  for (t=base; t<=iterpushed(I); t++) N->num[I->F[t].j]++;
+  iteravail(I);
+  for (t=base; t<=iterpushed(I); t++)
+    if (--N->num[I->F[t].j]==0) cellremove(I->avail,I->F[t].j,&I->head);
+  for (t=1; t<=iterpushed(I); t++) argpush(N,I->a,t,args);
+  return I;
+}
+
+/**
+ * @brief Free an iterator.
+ *
+ * Unwinds what is left of the recursion first, so the arguments and the
+ * content <b><tt>N->num</tt></b> are as after a complete run.
+ *
+ * @param[in,out] I iterator
+ */
+void Iterfree(iter_t *I)
+{
+  neck_t *N=I->N;
+  unsigned t;
+
+  if (I->yielded && N->argfree!=NULL) N->argfree(I->args);
+  if (I->top>=I->base) {
+    for (t=iterpushed(I); t>=I->base; t--) {
+      argpop(N,I->a,t,I->args);
+      iterunplace(I,I->F+t);
+      I->a[t]=N->k;
+    }
+    I->top=I->base;
+    iterup(I);
+  }
+  free(I);
+}
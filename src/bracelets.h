@@ -6,6 +6,10 @@
 # ifndef BRACELETS_H
 # define BRACELETS_H
 
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+
 /* project headers */
 # include <defs.h>
 
@@ -25,4 +29,33 @@ void FCBracelet(neck_t*, void*
 # endif
                 );
 
+void FCBraceletsub(neck_t*, const node_t*, void*
+# if HAVE_PTHREAD
+                   ,pthread_mutex_t*
+# endif
+                   );
+
+void FCNecklacesub(neck_t*, const node_t*, void*
+# if HAVE_PTHREAD
+                   ,pthread_mutex_t*
+# endif
+                   );
+
+node_t *Nodecopy(const node_t*, const neck_t*);
+void Nodefree(node_t*);
+double Nodearrangements(const node_t*, unsigned);
+
+# define ITERMAGIC "LPQI" ///< magic of saved iterators (see Itersave)
+
+/** @brief Pull-style generator of necklaces/bracelets (see Braceletiter). */
+typedef struct iter iter_t;
+
+iter_t *Braceletiter(neck_t*, const node_t*, void*);
+iter_t *Necklaceiter(neck_t*, void*);
+const unsigned *Iternext(iter_t*);
+size_t Iternextbatch(iter_t*, unsigned*, size_t);
+void Itersave(const iter_t*, FILE*);
+iter_t *Iterload(FILE*, neck_t*, void*);
+void Iterfree(iter_t*);
+
 # endif
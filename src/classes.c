@@ -0,0 +1,219 @@
+/**
+ * @file classes.c
+ * @brief Content classes of the A and B searches.
+ *
+ * The strings of A and B are split by content (number of \sqrt{-1}s) into
+ * classes, each enumerated as fixed content bracelets. The initializers live
+ * in the library so that A, B, the fused pair search and the unrestricted
+ * search U share them.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdlib.h>
+
+/* project headers */
+# include <defs.h>
+# include <seq_funcs.h>
+# include <classes.h>
+
+/**
+ * @brief Initialize the bracelet structure and arguments of an A content class.
+ *
+ * Fixed content quaternary braceletes with real-valued periodic
+ * auto-correlations. Braceletes must have bounded square norm <= 2N+2. The
+ * sum of the entries must be 0.
+ *
+ * @param[in] N string length
+ * @param[in] nonreal number of \sqrt{-1}s in strings
+ * @param[out] neck bracelet structure (free with Neckfree)
+ * @param[out] args sequence arguments (free with Argfree)
+ */
+void Aclassinit(unsigned N, unsigned nonreal, neck_t *neck, args_t *args)
+{
+  *neck=(neck_t){.n=N,.k=nonreal==0 ? 2 : K,
+                 .arginit=arginit,.argfree=NULL,.seqprint=printseq};
+  neck->num=(unsigned*)calloc(nonreal==0 ? 3 : K+1,sizeof(unsigned));
+
+  *args=(args_t){.n=N};
+  Argalloc(args,neck->k);
+
+  /* initialize bracelet arguments and necklace parameters */
+  if (nonreal==0) { /* strongly restricted case */
+    /* the strings are generated and evaluated on machine words (see
+       FCBracelet) */
+    neck->arginit=argbinary;
+    args->nummap[1]=0;
+    args->nummap[2]=2;
+    neck->num[1]=args->l;
+    neck->num[2]=args->l;
+
+    neck->ncheckfuncs=1;
+    neck->checkfuncs=(check_t*)malloc(sizeof(check_t));
+    neck->checkfuncs[0]=psdtest;
+  }
+  else { /* restricted cases (there are nonreal entries) */
+    args->nummap[1]=1;
+    args->nummap[2]=3;
+    args->nummap[3]=0;
+    args->nummap[4]=2;
+    neck->num[1]=nonreal;
+    neck->num[2]=nonreal;
+    neck->num[3]=args->l-nonreal;
+    neck->num[4]=args->l-nonreal;
+
+    neck->ncheckfuncs=2;
+    neck->checkfuncs=(check_t*)malloc(2*sizeof(check_t));
+    neck->checkfuncs[0]=realcorrs;
+    neck->checkfuncs[1]=psdtest;
+  }
+  Argkernel(neck);
+}
+
+/**
+ * @brief Initialize the bracelet structure and arguments of a B content class.
+ *
+ * Fixed content quaternary braceletes with real-valued periodic
+ * auto-correlations. Braceletes must have bounded square norm <= 2N+2. The
+ * sum of the entries must be 1+i.
+ *
+ * @param[in] N string length
+ * @param[in] cls content class (number of \sqrt{-1}s in strings less one)
+ * @param[out] neck bracelet structure (free with Neckfree)
+ * @param[out] args sequence arguments (free with Argfree)
+ */
+void Bclassinit(unsigned N, unsigned cls, neck_t *neck, args_t *args)
+{
+  unsigned nonreal=cls+1;
+
+  *neck=(neck_t){.n=N,.k=(nonreal==1 || nonreal==N/2) ? 3 : K,
+                 .ncheckfuncs=2,.arginit=arginit,.argfree=NULL,
+                 .seqprint=printseq};
+
+  neck->num=(unsigned*)calloc(neck->k+1,sizeof(unsigned));
+  neck->checkfuncs=(check_t*)malloc(neck->ncheckfuncs*sizeof(check_t));
+  neck->checkfuncs[0]=realcorrs;
+  neck->checkfuncs[1]=psdtest;
+
+  *args=(args_t){.n=N};
+  Argalloc(args,neck->k);
+
+  /* initialize bracelet arguments and necklace parameters */
+  if (neck->k==3) {
+    if (nonreal==1) {
+      args->nummap[1]=1;
+      args->nummap[2]=2;
+      args->nummap[3]=0;
+    }
+    else {
+      args->nummap[1]=0;
+      args->nummap[2]=3;
+      args->nummap[3]=1;
+    }
+    neck->num[1]=1;
+    neck->num[2]=neck->n/2-1;
+    neck->num[3]=neck->n/2;
+  }
+  else if (nonreal>neck->n/2) {
+    args->nummap[1]=2;
+    args->nummap[2]=0;
+    args->nummap[3]=3;
+    args->nummap[4]=1;
+    neck->num[1]=(neck->n+2)/2-nonreal-1;
+    neck->num[2]=(neck->n+2)/2-nonreal;
+    neck->num[3]=nonreal-1;
+    neck->num[4]=nonreal;
+  }
+  else {
+    args->nummap[1]=3;
+    args->nummap[2]=1;
+    args->nummap[3]=2;
+    args->nummap[4]=0;
+    neck->num[1]=nonreal-1;
+    neck->num[2]=nonreal;
+    neck->num[3]=(neck->n+2)/2-nonreal-1;
+    neck->num[4]=(neck->n+2)/2-nonreal;
+  }
+  Argkernel(neck);
+}
+
+/**
+ * @brief Initialize the bracelet structure and arguments of an unrestricted
+ * content class of sum 0.
+ *
+ * The strings of the A content class, with correlations no longer required to
+ * be real (see Argcomplex). Reversing both strings of a Legendre pair
+ * conjugates the correlations of both, so one side may still be reduced to
+ * bracelets; these are.
+ *
+ * @param[in] N string length
+ * @param[in] nonreal number of \sqrt{-1}s in strings
+ * @param[out] neck bracelet structure (free with Neckfree)
+ * @param[out] args sequence arguments (free with Argfree)
+ */
+void UAclassinit(unsigned N, unsigned nonreal, neck_t *neck, args_t *args)
+{
+  Aclassinit(N,nonreal,neck,args);
+  Argcomplex(neck,args);
+}
+
+/**
+ * @brief Initialize the necklace structure and arguments of an unrestricted
+ * content class of sum 1+i.
+ *
+ * The strings of the B content class, with correlations no longer required to
+ * be real (see Argcomplex), as necklaces: the partners of the bracelets of
+ * UAclassinit may be any rotation of the reversal of a string. The necklaces
+ * are pruned on the character sums of their prefixes (see argpushcomplex).
+ *
+ * @param[in] N string length
+ * @param[in] cls content class (number of \sqrt{-1}s in strings less one)
+ * @param[out] neck necklace structure (free with Neckfree)
+ * @param[out] args sequence arguments (free with Argfree)
+ */
+void UBclassinit(unsigned N, unsigned cls, neck_t *neck, args_t *args)
+{
+  Bclassinit(N,cls,neck,args);
+  Argcomplex(neck,args);
+  neck->argpush=argpushcomplex;
+  neck->argpop=argpop;
+  neck->necklaces=true;
+}
+
+/**
+ * @brief Number of A content classes.
+ * @param[in] N string length
+ * @retval nclasses Return the number of distinct contents.
+ */
+unsigned Aclasses(unsigned N)
+{
+  return (N-(N&3U))/4 + 1;
+}
+
+/**
+ * @brief Number of B content classes.
+ * @param[in] N string length
+ * @retval nclasses Return the number of distinct contents.
+ */
+unsigned Bclasses(unsigned N)
+{
+  return N/2;
+}
+
+/**
+ * @brief Number of B content classes up to conjugation.
+ *
+ * Multiplying the conjugate of a B string by i keeps its sum 1+i and its
+ * correlations, and maps content class c to class (N-2)/2-c (see Bclassinit).
+ * The classes up to the one mapped to itself, if any, hold a representative of
+ * every orbit; the strings of that one are reduced by symtest (see Argsym).
+ *
+ * @param[in] N string length
+ * @retval nclasses Return the number of classes to search.
+ */
+unsigned Bsymclasses(unsigned N)
+{
+  return (N+2)/4;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file classes.h
+ * @brief Content classes of the A and B searches declarations.
+ * @author Thomas Pender
+ */
+# ifndef CLASSES_H
+# define CLASSES_H
+
+/* project headers */
+# include <defs.h>
+# include <seq_funcs.h>
+
+void Aclassinit(unsigned, unsigned, neck_t*, args_t*);
+void Bclassinit(unsigned, unsigned, neck_t*, args_t*);
+void UAclassinit(unsigned, unsigned, neck_t*, args_t*);
+void UBclassinit(unsigned, unsigned, neck_t*, args_t*);
+unsigned Aclasses(unsigned);
+unsigned Bclasses(unsigned);
+unsigned Bsymclasses(unsigned);
+
+# endif
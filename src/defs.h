@@ -16,12 +16,47 @@ typedef void (*arg_init_t)(const unsigned*, void*);
 /** @brief Deallocator for auxilary data structures. */
 typedef void (*arg_free_t)(void*);
 
+/**
+ * @brief Update of auxilary data once a string position is fixed. Returns
+ * whether strings with the current prefix may still pass the boolean checks.
+ */
+typedef bool (*arg_push_t)(const unsigned*, unsigned, void*);
+
+/** @brief Undo the update of arg_push_t. */
+typedef void (*arg_pop_t)(const unsigned*, unsigned, void*);
+
 /** @brief Boolean check for encountered necklace/bracelet. */
 typedef bool (*check_t)(const void*);
 
 /** @brief Printing method for encountered necklace/bracelet. */
 typedef void (*seq_print_t)(const unsigned*, const void*);
 
+/** @brief Run-length block (letter and multiplicity). */
+typedef struct {
+  unsigned s, v;
+} elem_t;
+
+/**
+ * @brief Node of the fixed content bracelet recursion.
+ *
+ * Holds everything required to continue the recursion below the node, so that
+ * subtrees may be handed out as independent tasks (see FCBraceletsub). Nodes
+ * of the necklace recursion (see FCNecklacesub) keep its parameter s in
+ * <b><tt>z</tt></b> and no run-length blocks.
+ */
+typedef struct {
+  unsigned t, p, r, z, b; ///< recursion parameters of the node
+  bool RS;                ///< reversal flag of the node
+  unsigned nb;            ///< number of run-length blocks
+  unsigned *a;            ///< string prefix (entries 1..t-1 are fixed)
+  unsigned *run;          ///< run array of the recursion
+  unsigned *num;          ///< remaining string content
+  elem_t *elems;          ///< run-length blocks of the prefix
+} node_t;
+
+/** @brief Receives the nodes at the split depth (see neck_t). */
+typedef void (*split_t)(const node_t*, void*);
+
 /**
  * @brief Contains structural parameters and user defined functions to be performed
  * for each encountered necklaces/bracelets.
@@ -33,8 +68,16 @@ typedef struct {
   unsigned ncheckfuncs; ///< number of boolean checks (see check_t)
   arg_init_t arginit;   ///< memory allocation
   arg_free_t argfree;   ///< memory deallocation
+  arg_push_t argpush;   ///< prefix update and subtree pruning (may be NULL)
+  arg_pop_t argpop;     ///< undo of argpush (may be NULL)
+  unsigned long nodes;  ///< string positions fixed so far (see stats_t)
   check_t *checkfuncs;  ///< boolean checks
-  seq_print_t seqprint; ///< printing method
+  seq_print_t seqprint; ///< printing method (not serialized by the caller)
+  unsigned depth;       ///< prefix length at which nodes are split off
+  split_t split;        ///< receives split off nodes (NULL: no splitting)
+  void *splitarg;       ///< user data passed to split
+  void *work;           ///< arrays of FCBraceletsub, kept between calls
+  bool necklaces;       ///< whether the searches generate necklaces (see FCNecklace)
 } neck_t;
 
 # endif
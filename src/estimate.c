@@ -0,0 +1,279 @@
+/**
+ * @file estimate.c
+ * @brief Estimate of the size and running time of a search.
+ *
+ * Knuth's estimator: a probe walks down the bracelet recursion from the root,
+ * at every node picking one of the children passing argpush uniformly at
+ * random, and weighs what it sees below a node by the product of the numbers
+ * of children along its path. The average over the probes is an unbiased
+ * estimate of the total.
+ *
+ * Once the content left to place has few arrangements (see Nodearrangements),
+ * the probe enumerates the whole subtree instead, timed, with the real checks
+ * of the content class (see seq_funcs.c). This estimates the number of
+ * strings generated and passing each check, and the time taken, as well as
+ * the number of nodes.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <math.h>
+# include <time.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <defs.h>
+# include <bracelets.h>
+# include <seq_funcs.h>
+# include <search.h>
+# include <estimate.h>
+
+# define SUBTREE 4096.0 ///< arrangements below which subtrees are enumerated
+# define STAGES 4       ///< strings generated, passing realcorrs, psdtest and filtertest
+
+/** @cond */
+
+typedef struct {
+  args_t args;            /* first: the methods are handed a pointer to it */
+  arg_push_t argpush;     /* prefix update of the content class */
+  check_t *checks;        /* checks of the content class */
+  unsigned nchecks;
+  unsigned content[K+1];  /* content of the class */
+  unsigned from;          /* pushes of positions >= from are counted */
+  double pushes;          /* number of counted pushes (nodes) */
+  double strings[STAGES]; /* strings generated and passing each check */
+} est_t;
+
+typedef struct {
+  const neck_t *neck;
+  node_t **nodes;
+  size_t count, cap;
+} children_t;
+
+typedef struct {
+  double nodes, strings[STAGES], seconds;
+} total_t;
+
+static inline
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+1e-9*(double)ts.tv_nsec;
+}
+
+/* splitmix64 */
+static inline
+uint64_t rnd(uint64_t *state)
+{
+  uint64_t z=(*state+=UINT64_C(0x9e3779b97f4a7c15));
+  z=(z^(z>>30U))*UINT64_C(0xbf58476d1ce4e5b9);
+  z=(z^(z>>27U))*UINT64_C(0x94d049bb133111eb);
+  return z^(z>>31U);
+}
+
+static
+bool estpush(const unsigned *a, unsigned t, void *_E)
+{
+  est_t *E=(est_t*)_E;
+  if (t>=E->from) E->pushes++;
+  return E->argpush==NULL || E->argpush(a,t,_E);
+}
+
+/* every string reaches this method (no checks in the neck) */
+static
+void estseq(const unsigned *a, const void *_E)
+{
+  est_t *E=(est_t*)_E;
+  unsigned i, s, fail=STAGES;
+  (void)a;
+
+  for (i=0; i<E->nchecks; i++)
+    if (!E->checks[i](&E->args)) {
+      /* the checks of a class may be fused (see Argkernel); unrestricted
+         strings need no real correlations (see Argcomplex) */
+      fail=E->checks[i]==filtertest ? 3
+        : !E->args.realcorrs && E->checks[i]!=complexpsdtest ? 1 : 2;
+      break;
+    }
+  for (s=0; s<fail; s++) E->strings[s]++;
+}
+
+static
+void collectchild(const node_t *node, void *_C)
+{
+  children_t *C=(children_t*)_C;
+  if (C->count==C->cap) {
+    C->cap=C->cap==0 ? 16 : 2*C->cap;
+    C->nodes=(node_t**)realloc(C->nodes,C->cap*sizeof(node_t*));
+    if (C->nodes==NULL) error(1, errno, "realloc failed");
+  }
+  C->nodes[C->count++]=Nodecopy(node,C->neck);
+}
+
+static inline
+void runsub(neck_t *N, const node_t *node, est_t *E)
+{
+  if (N->necklaces)
+    FCNecklacesub(N,node,&E->args
+# if HAVE_PTHREAD
+                  ,NULL
+# endif
+                  );
+  else
+    FCBraceletsub(N,node,&E->args
+# if HAVE_PTHREAD
+                  ,NULL
+# endif
+                  );
+}
+
+/* one probe from the root, its estimates added to T (and squares to T2) */
+static
+void probe(neck_t *N, est_t *E, uint64_t *seed, total_t *T, total_t *T2)
+{
+  children_t C={.neck=N,.nodes=NULL,.count=0,.cap=0};
+  node_t *node;
+  double w=1, nodes, t0;
+  total_t P={0};
+  size_t i, pick;
+  unsigned s;
+
+  /* the first position is fixed (FCBraceletsub overwrote the content) */
+  for (i=0; i<=N->k; i++) N->num[i]=E->content[i];
+  N->split=collectchild;
+  N->splitarg=&C;
+  N->depth=1;
+  E->from=1;
+  E->pushes=0;
+  if (N->necklaces)
+    FCNecklace(N,&E->args
+# if HAVE_PTHREAD
+               ,NULL
+# endif
+               );
+  else
+    FCBracelet(N,&E->args
+# if HAVE_PTHREAD
+               ,NULL
+# endif
+               );
+  P.nodes=E->pushes;
+
+  while (C.count>0) {
+    w*=(double)C.count;
+    pick=(size_t)(rnd(seed)%C.count);
+    node=C.nodes[pick];
+    for (i=0; i<C.count; i++) if (i!=pick) Nodefree(C.nodes[i]);
+    C.count=0;
+
+    E->from=node->t;
+    E->pushes=0;
+    if (Nodearrangements(node,N->k)<=SUBTREE) { /* enumerate the rest */
+      for (s=0; s<STAGES; s++) E->strings[s]=0;
+      N->split=NULL;
+      t0=now();
+      runsub(N,node,E);
+      P.seconds=w*(now()-t0);
+      P.nodes+=w*E->pushes;
+      for (s=0; s<STAGES; s++) P.strings[s]=w*E->strings[s];
+    }
+    else { /* collect the children */
+      N->split=collectchild;
+      N->depth=node->t;
+      runsub(N,node,E);
+      P.nodes+=w*E->pushes;
+    }
+    Nodefree(node);
+  }
+  if (C.nodes!=NULL) free(C.nodes);
+
+  nodes=P.nodes;
+  T->nodes+=nodes;
+  T2->nodes+=nodes*nodes;
+  T->seconds+=P.seconds;
+  for (s=0; s<STAGES; s++) T->strings[s]+=P.strings[s];
+}
+
+/** @endcond */
+
+/**
+ * @brief Estimate the size and running time of a search.
+ *
+ * Runs <b><tt>S->probes</tt></b> random probes per content class (see
+ * estimate.c) on a single thread and prints, per class and in total, the
+ * estimated number of nodes of the recursion, of strings generated and
+ * passing realcorrs, psdtest and (with <b><tt>S->filter</tt></b>)
+ * filtertest, and of seconds of a single worker, as well as the wall-clock
+ * time with <b><tt>S->nthreads</tt></b> workers. Probes are seeded the same
+ * way every time, so estimates are reproducible.
+ *
+ * @param[in,out] S search parameters
+ */
+void Estimate(search_t *S)
+{
+  neck_t neck;
+  est_t E;
+  total_t T, T2, all={0};
+  uint64_t seed=UINT64_C(0x4c50514553544d31);
+  double p=(double)S->probes, rse2=0;
+  unsigned i, s;
+  unsigned long j;
+
+  printf("# estimate of the %c search of length %u (%lu probes per class)\n",
+         S->kind,S->n,S->probes);
+  printf("# %5s %12s %12s %12s %12s%s %12s\n","class","nodes","strings",
+         "realcorrs","psdtest",S->filter!=NULL ? "   filtertest" : "",
+         "seconds");
+  for (i=0; i<S->nclasses; i++) {
+    S->classinit(S->n,i,&neck,&E.args);
+    E.argpush=neck.argpush;
+    E.checks=neck.checkfuncs;
+    E.nchecks=neck.ncheckfuncs;
+    if (S->filter!=NULL) {
+      E.checks=(check_t*)realloc(E.checks,(E.nchecks+1)*sizeof(check_t));
+      if (E.checks==NULL) error(1, errno, "realloc failed");
+      E.checks[E.nchecks++]=filtertest;
+      E.args.filter=S->filter;
+    }
+    for (s=0; s<=neck.k; s++) E.content[s]=neck.num[s];
+    neck.checkfuncs=E.checks;
+    neck.argpush=estpush;
+    neck.ncheckfuncs=0;
+    neck.seqprint=estseq;
+
+    T=T2=(total_t){0};
+    for (j=0; j<S->probes; j++) probe(&neck,&E,&seed,&T,&T2);
+
+    printf("  %5u %12.4g",i,T.nodes/p);
+    for (s=0; s<(S->filter!=NULL ? STAGES : STAGES-1); s++)
+      printf(" %12.4g",T.strings[s]/p);
+    printf(" %12.4g\n",T.seconds/p);
+
+    all.nodes+=T.nodes/p;
+    all.seconds+=T.seconds/p;
+    for (s=0; s<STAGES; s++) all.strings[s]+=T.strings[s]/p;
+    if (S->probes>1) /* variance of the class mean */
+      rse2+=(T2.nodes/p-(T.nodes/p)*(T.nodes/p))/(p-1);
+
+    Argfree(&E.args);
+    Neckfree(&neck);
+  }
+
+  printf("  %5s %12.4g","total",all.nodes);
+  for (s=0; s<(S->filter!=NULL ? STAGES : STAGES-1); s++)
+    printf(" %12.4g",all.strings[s]);
+  printf(" %12.4g\n",all.seconds);
+  if (all.nodes>0)
+    printf("# relative standard error of the node count: %.1f%%\n",
+           100*sqrt(rse2>0 ? rse2 : 0)/all.nodes);
+  printf("# wall-clock time with %u workers: %.4g seconds\n",S->nthreads,
+         all.seconds/S->nthreads);
+}
@@ -0,0 +1,14 @@
+/**
+ * @file estimate.h
+ * @brief Estimate of the size and running time of a search declarations.
+ * @author Thomas Pender
+ */
+# ifndef ESTIMATE_H
+# define ESTIMATE_H
+
+/* project headers */
+# include <search.h>
+
+void Estimate(search_t*);
+
+# endif
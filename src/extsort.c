@@ -0,0 +1,276 @@
+/**
+ * @file extsort.c
+ * @brief External sort of A/B output files by correlations.
+ *
+ * The records of an output file are gathered into a buffer of bounded size,
+ * sorted by their correlation vectors and written to a temporary file as a
+ * sorted run. The runs are then merged with a heap, in several passes if there
+ * are more than MAXFANIN of them, so that the records come back in key order
+ * while only one record per run is held in memory.
+ *
+ * The keys are compared bytewise, which is all a merge join needs: both sides
+ * are sorted by the same order. The keys of one side may be replaced by their
+ * complements -2 - R (see Joincomplement), so that partners have equal keys.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <string.h>
+# include <unistd.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <extsort.h>
+# include <join.h>
+
+# define MAXFANIN 64 ///< largest number of runs merged at once
+
+/** @cond */
+
+typedef struct {
+  FILE **in;
+  char **bufs;        /* stdio buffers of the runs */
+  size_t k;
+  unsigned char *cur; /* current record of every run */
+  size_t *heap, nheap;
+} merge_t;
+
+struct runs {
+  unsigned n, l;
+  size_t rec;    /* record size: l key bytes followed by n string bytes */
+  size_t budget; /* memory budget in bytes */
+  FILE **files;
+  size_t nfiles, cap;
+  merge_t *M;    /* final merge, set up by the first Runsnext */
+};
+
+static unsigned keylen; /* key length for keycmp (qsort has no context) */
+
+static
+int keycmp(const void *a, const void *b)
+{
+  return memcmp(a,b,keylen);
+}
+
+/* anonymous temporary file in $TMPDIR (default /tmp) */
+static
+FILE *runopen(void)
+{
+  const char *dir=getenv("TMPDIR");
+  char path[4096];
+  int fd;
+  FILE *f;
+
+  snprintf(path,sizeof(path),"%s/legendre.XXXXXX",
+           dir!=NULL && *dir!='\0' ? dir : "/tmp");
+  if ( (fd=mkstemp(path))<0 ) error(1, errno, "mkstemp failed");
+  unlink(path);
+  if ( (f=fdopen(fd,"w+b"))==NULL ) error(1, errno, "fdopen failed");
+  return f;
+}
+
+static
+void runadd(runs_t *S, FILE *f)
+{
+  if (S->nfiles==S->cap) {
+    S->cap=S->cap==0 ? 16 : 2*S->cap;
+    S->files=(FILE**)realloc(S->files,S->cap*sizeof(FILE*));
+    if (S->files==NULL) error(1, errno, "realloc failed");
+  }
+  rewind(f);
+  S->files[S->nfiles++]=f;
+}
+
+static
+void runflush(runs_t *S, unsigned char *buf, size_t count)
+{
+  FILE *f=runopen();
+  keylen=S->l;
+  qsort(buf,count,S->rec,keycmp);
+  if (fwrite(buf,S->rec,count,f)!=count) error(1, errno, "fwrite failed");
+  if (fflush(f)!=0) error(1, errno, "fflush failed");
+  runadd(S,f);
+}
+
+static inline
+int heapcmp(const runs_t *S, const merge_t *M, size_t i, size_t j)
+{
+  return memcmp(M->cur+M->heap[i]*S->rec,M->cur+M->heap[j]*S->rec,S->l);
+}
+
+static
+void heapdown(const runs_t *S, merge_t *M, size_t i)
+{
+  size_t c, t;
+  while ( (c=2*i+1)<M->nheap ) {
+    if (c+1<M->nheap && heapcmp(S,M,c+1,c)<0) c++;
+    if (heapcmp(S,M,c,i)>=0) break;
+    t=M->heap[i]; M->heap[i]=M->heap[c]; M->heap[c]=t;
+    i=c;
+  }
+}
+
+static
+merge_t *mergeinit(runs_t *S, FILE **in, size_t k)
+{
+  merge_t *M=(merge_t*)malloc(sizeof(merge_t));
+  size_t i, bufsize=S->budget/(k+1);
+
+  if (bufsize<BUFSIZ) bufsize=BUFSIZ;
+  M->in=in;
+  M->k=k;
+  M->bufs=(char**)malloc(k*sizeof(char*));
+  M->cur=(unsigned char*)malloc(k*S->rec);
+  M->heap=(size_t*)malloc(k*sizeof(size_t));
+  M->nheap=0;
+  for (i=0; i<k; i++) {
+    M->bufs[i]=(char*)malloc(bufsize);
+    setvbuf(in[i],M->bufs[i],_IOFBF,bufsize);
+    if (fread(M->cur+i*S->rec,S->rec,1,in[i])==1) M->heap[M->nheap++]=i;
+  }
+  for (i=M->nheap/2; i-->0;) heapdown(S,M,i);
+  return M;
+}
+
+static
+bool mergepop(runs_t *S, merge_t *M, unsigned char *rec)
+{
+  size_t r;
+  if (M->nheap==0) return false;
+  r=M->heap[0];
+  memcpy(rec,M->cur+r*S->rec,S->rec);
+  if (fread(M->cur+r*S->rec,S->rec,1,M->in[r])!=1) {
+    if (ferror(M->in[r])) error(1, errno, "fread failed");
+    M->heap[0]=M->heap[--M->nheap];
+  }
+  heapdown(S,M,0);
+  return true;
+}
+
+static
+void mergefree(merge_t *M)
+{
+  for (size_t i=0; i<M->k; i++) {
+    fclose(M->in[i]);
+    free(M->bufs[i]);
+  }
+  free(M->bufs);
+  free(M->cur);
+  free(M->heap);
+  free(M);
+}
+
+/* merge groups of MAXFANIN runs until at most MAXFANIN runs are left */
+static
+void mergepasses(runs_t *S)
+{
+  unsigned char rec[S->rec];
+  FILE **old, *f;
+  size_t i, k, nold;
+  merge_t *M;
+
+  while (S->nfiles>MAXFANIN) {
+    old=S->files;
+    nold=S->nfiles;
+    S->files=NULL;
+    S->nfiles=S->cap=0;
+    for (i=0; i<nold; i+=k) {
+      k=nold-i<MAXFANIN ? nold-i : MAXFANIN;
+      f=runopen();
+      M=mergeinit(S,old+i,k);
+      while (mergepop(S,M,rec))
+        if (fwrite(rec,S->rec,1,f)!=1) error(1, errno, "fwrite failed");
+      mergefree(M);
+      if (fflush(f)!=0) error(1, errno, "fflush failed");
+      runadd(S,f);
+    }
+    free(old);
+  }
+}
+
+/** @endcond */
+
+/**
+ * @brief Split an output file into sorted runs.
+ *
+ * @param[in,out] R reader of the output file
+ * @param[in] budget memory budget in bytes
+ * @param[in] complement whether the records are keyed on the complements of
+ * their correlations (see Joincomplement)
+ *
+ * @retval runs Return the sorted runs (free with Runsfree).
+ */
+runs_t *Runsplit(reader_t *R, size_t budget, bool complement)
+{
+  runs_t *S=(runs_t*)calloc(1,sizeof(runs_t));
+  unsigned char *buf, *p;
+  size_t count=0, cap;
+
+  S->n=Readerlength(R);
+  S->l=Readercorrs(R);
+  S->rec=S->l+S->n;
+  S->budget=budget;
+  if (S->n==0) return S;
+
+  char seq[S->n+1];
+  signed char corrs[S->l];
+  cap=budget/S->rec>0 ? budget/S->rec : 1;
+  if ( (buf=(unsigned char*)malloc(cap*S->rec))==NULL )
+    error(1, errno, "Runsplit -- malloc failed");
+  while (Readernext(R,seq,corrs)) {
+    p=buf+count*S->rec;
+    if (complement) Joincomplement(corrs,(signed char*)p,S->l);
+    else memcpy(p,corrs,S->l);
+    memcpy(p+S->l,seq,S->n);
+    if (++count==cap) {
+      runflush(S,buf,count);
+      count=0;
+    }
+  }
+  if (count>0) runflush(S,buf,count);
+  free(buf);
+  return S;
+}
+
+/**
+ * @brief Next record in key order.
+ *
+ * @param[in,out] S sorted runs
+ * @param[out] key key of the record (n/2 bytes)
+ * @param[out] seq string as text (n characters and a terminating zero)
+ *
+ * @retval read Return whether a record was read.
+ */
+bool Runsnext(runs_t *S, signed char *key, char *seq)
+{
+  unsigned char rec[S->rec+1];
+  if (S->nfiles==0) return false;
+  if (S->M==NULL) {
+    mergepasses(S);
+    S->M=mergeinit(S,S->files,S->nfiles);
+  }
+  if (!mergepop(S,S->M,rec)) return false;
+  memcpy(key,rec,S->l);
+  memcpy(seq,rec+S->l,S->n);
+  seq[S->n]='\0';
+  return true;
+}
+
+/**
+ * @brief Free sorted runs and remove their files.
+ * @param[in,out] S sorted runs
+ */
+void Runsfree(runs_t *S)
+{
+  if (S->M!=NULL) mergefree(S->M);
+  else
+    for (size_t i=0; i<S->nfiles; i++) fclose(S->files[i]);
+  if (S->files!=NULL) free(S->files);
+  free(S);
+}
@@ -0,0 +1,23 @@
+/**
+ * @file extsort.h
+ * @brief External sort of A/B output files by correlations declarations.
+ * @author Thomas Pender
+ */
+# ifndef EXTSORT_H
+# define EXTSORT_H
+
+/* std headers */
+# include <stddef.h>
+# include <stdbool.h>
+
+/* project headers */
+# include <records.h>
+
+/** @brief Sorted runs of an output file on disk (see extsort.c). */
+typedef struct runs runs_t;
+
+runs_t *Runsplit(reader_t*, size_t, bool);
+bool Runsnext(runs_t*, signed char*, char*);
+void Runsfree(runs_t*);
+
+# endif
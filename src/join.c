@@ -0,0 +1,330 @@
+/**
+ * @file join.c
+ * @brief Hash join of A and B strings on their correlations.
+ *
+ * Strings of one side are stored in an open-addressing hash table (linear
+ * probing) keyed on their packed correlation vectors. Strings sharing the same
+ * correlations are chained. A string R of the other side forms a Legendre pair
+ * with every stored string whose correlations equal -2 - R at every shift (see
+ * Joincomplement), so matching is a single probe per string.
+ *
+ * A table may hold references to the strings (e.g. their offsets in a mapped
+ * file, see Readerscan) instead of copies of them, so that it takes little
+ * more memory than the keys.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdint.h>
+# include <string.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <join.h>
+
+/** @cond */
+
+struct join {
+  unsigned n, l;
+  size_t cap;          /* number of slots, a power of 2 */
+  size_t *slots;       /* key index + 1, or 0 if empty */
+  size_t nkeys, keycap;
+  signed char *keys;   /* correlation vectors, l bytes each */
+  uint64_t *hashes;    /* hash of every key */
+  size_t *heads;       /* first string of every key */
+  size_t nseqs, seqcap;
+  char *seqs;          /* strings, n+1 bytes each, numbered from 1 */
+  size_t *refs;        /* or their references if n is 0 */
+  size_t *next;        /* next string of the same key, or 0 */
+};
+
+static inline
+uint64_t keyhash(const signed char *key, unsigned l)
+{
+  uint64_t h=UINT64_C(14695981039346656037); /* FNV-1a */
+  for (unsigned i=0; i<l; i++) {
+    h^=(unsigned char)key[i];
+    h*=UINT64_C(1099511628211);
+  }
+  return h^(h>>32U);
+}
+
+static inline
+void *resize(void *p, size_t size)
+{
+  if ( (p=realloc(p,size))==NULL ) error(1, errno, "realloc failed");
+  return p;
+}
+
+static inline
+void *zeroed(size_t nmemb, size_t size)
+{
+  void *p;
+  if ( (p=calloc(nmemb,size))==NULL ) error(1, errno, "calloc failed");
+  return p;
+}
+
+/* slot holding key, or the empty slot where it belongs */
+static inline
+size_t slotfind(const join_t *J, const signed char *key, uint64_t h)
+{
+  size_t i=(size_t)h&(J->cap-1), id;
+  while ( (id=J->slots[i])!=0 ) {
+    id--;
+    if (J->hashes[id]==h && memcmp(J->keys+id*J->l,key,J->l)==0) break;
+    i=(i+1)&(J->cap-1);
+  }
+  return i;
+}
+
+static
+void rehash(join_t *J)
+{
+  size_t i, id;
+  free(J->slots);
+  J->cap*=2;
+  J->slots=(size_t*)zeroed(J->cap,sizeof(size_t));
+  for (id=0; id<J->nkeys; id++) {
+    i=(size_t)J->hashes[id]&(J->cap-1);
+    while (J->slots[i]!=0) i=(i+1)&(J->cap-1);
+    J->slots[i]=id+1;
+  }
+}
+
+/* number of a new string stored under key */
+static
+size_t seqnew(join_t *J, const signed char *corrs)
+{
+  uint64_t h=keyhash(corrs,J->l);
+  size_t i=slotfind(J,corrs,h), id, s;
+
+  if (J->slots[i]==0) { /* new key */
+    if (2*(J->nkeys+1)>J->cap) {
+      rehash(J);
+      i=slotfind(J,corrs,h);
+    }
+    if (J->nkeys==J->keycap) {
+      J->keycap=J->keycap==0 ? 1024 : 2*J->keycap;
+      J->keys=(signed char*)resize(J->keys,J->keycap*J->l);
+      J->hashes=(uint64_t*)resize(J->hashes,J->keycap*sizeof(uint64_t));
+      J->heads=(size_t*)resize(J->heads,J->keycap*sizeof(size_t));
+    }
+    id=J->nkeys++;
+    memcpy(J->keys+id*J->l,corrs,J->l);
+    J->hashes[id]=h;
+    J->heads[id]=0;
+    J->slots[i]=id+1;
+  }
+  id=J->slots[i]-1;
+
+  s=++J->nseqs;
+  if (s>=J->seqcap) {
+    J->seqcap=J->seqcap==0 ? 1024 : 2*J->seqcap;
+    if (J->n>0) J->seqs=(char*)resize(J->seqs,J->seqcap*(J->n+1));
+    else J->refs=(size_t*)resize(J->refs,J->seqcap*sizeof(size_t));
+    J->next=(size_t*)resize(J->next,J->seqcap*sizeof(size_t));
+  }
+  J->next[s]=J->heads[id];
+  J->heads[id]=s;
+  return s;
+}
+
+/** @endcond */
+
+/**
+ * @brief Create an empty hash table.
+ * @param[in] n string length, or 0 for a table of references to the strings
+ * (see Joinaddref)
+ * @param[in] l number of correlations of the strings (n/2, see Readercorrs)
+ * @retval table Return the table (free with Joinfree).
+ */
+join_t *Joininit(unsigned n, unsigned l)
+{
+  join_t *J=(join_t*)zeroed(1,sizeof(join_t));
+  J->n=n;
+  J->l=l;
+  J->cap=1024;
+  J->slots=(size_t*)zeroed(J->cap,sizeof(size_t));
+  return J;
+}
+
+/**
+ * @brief Store a string under its correlations.
+ *
+ * @param[in,out] J table
+ * @param[in] corrs the n/2 correlations of the string
+ * @param[in] seq string as text
+ */
+void Joinadd(join_t *J, const signed char *corrs, const char *seq)
+{
+  size_t s=seqnew(J,corrs);
+  memcpy(J->seqs+s*(J->n+1),seq,J->n+1);
+}
+
+/**
+ * @brief Store a reference to a string under its correlations, in a table of
+ * references (see Joininit).
+ *
+ * @param[in,out] J table
+ * @param[in] corrs the correlations of the string
+ * @param[in] ref reference to the string (e.g. see Readerscan)
+ */
+void Joinaddref(join_t *J, const signed char *corrs, size_t ref)
+{
+  size_t s=seqnew(J,corrs);
+  J->refs[s]=ref;
+}
+
+/**
+ * @brief Find the strings stored under given correlations.
+ *
+ * @param[in] J table
+ * @param[in] corrs the n/2 correlations
+ *
+ * @retval first Return the number of the first string (see Joinseq), or 0 if
+ * there is none.
+ */
+size_t Joinfind(const join_t *J, const signed char *corrs)
+{
+  size_t id=J->slots[slotfind(J,corrs,keyhash(corrs,J->l))];
+  return id==0 ? 0 : J->heads[id-1];
+}
+
+/**
+ * @brief String of a given number.
+ *
+ * @param[in] J table
+ * @param[in] s string number (see Joinfind)
+ * @param[out] next number of the next string with the same correlations, or 0
+ *
+ * @retval seq Return the string as text.
+ */
+const char *Joinseq(const join_t *J, size_t s, size_t *next)
+{
+  *next=J->next[s];
+  return J->seqs+s*(J->n+1);
+}
+
+/**
+ * @brief Reference of a given number, in a table of references (see
+ * Joinseq).
+ *
+ * @param[in] J table
+ * @param[in] s string number (see Joinfind)
+ * @param[out] next number of the next string with the same correlations, or 0
+ *
+ * @retval ref Return the reference to the string.
+ */
+size_t Joinref(const join_t *J, size_t s, size_t *next)
+{
+  *next=J->next[s];
+  return J->refs[s];
+}
+
+/**
+ * @brief Number of stored strings.
+ * @param[in] J table
+ * @retval size Return the number of strings.
+ */
+size_t Joinsize(const join_t *J)
+{
+  return J->nseqs;
+}
+
+/**
+ * @brief Add the strings of one table to another.
+ *
+ * @param[in,out] J table
+ * @param[in] other table of strings of the same length (or of references)
+ */
+void Joinmerge(join_t *J, const join_t *other)
+{
+  size_t id, s;
+  for (id=0; id<other->nkeys; id++)
+    for (s=other->heads[id]; s!=0; s=other->next[s])
+      if (J->n>0)
+        Joinadd(J,other->keys+id*other->l,other->seqs+s*(other->n+1));
+      else Joinaddref(J,other->keys+id*other->l,other->refs[s]);
+}
+
+/**
+ * @brief Free a hash table.
+ * @param[in,out] J table
+ */
+void Joinfree(join_t *J)
+{
+  free(J->slots);
+  if (J->keys!=NULL) free(J->keys);
+  if (J->hashes!=NULL) free(J->hashes);
+  if (J->heads!=NULL) free(J->heads);
+  if (J->seqs!=NULL) free(J->seqs);
+  if (J->refs!=NULL) free(J->refs);
+  if (J->next!=NULL) free(J->next);
+  free(J);
+}
+
+/**
+ * @brief Correlations required of the partner of a string.
+ *
+ * A and B form a Legendre pair iff their correlations add up to -2 at every
+ * shift.
+ *
+ * @param[in] corrs correlations of the string
+ * @param[out] comp correlations of its partners
+ * @param[in] l number of correlations
+ */
+void Joincomplement(const signed char *corrs, signed char *comp, unsigned l)
+{
+  for (unsigned i=0; i<l; i++) comp[i]=(signed char)(-2-corrs[i]);
+}
+
+/**
+ * @brief Format a Legendre pair.
+ *
+ * Same format as <b><tt>ordered_check_sums</tt></b>: each string followed by
+ * its correlations, and a blank line after the pair. At most PAIRSIZE(2l)
+ * bytes are written, including a terminating zero.
+ *
+ * @param[out] s buffer
+ * @param[in] a A string as text
+ * @param[in] ca correlations of the A string
+ * @param[in] b B string as text
+ * @param[in] cb correlations of the B string
+ * @param[in] l number of correlations
+ *
+ * @retval end Return the end of the formatted pair (the terminating zero).
+ */
+char *Pairformat(char *s, const char *a, const signed char *ca, const char *b,
+                 const signed char *cb, unsigned l)
+{
+  unsigned i;
+  s+=sprintf(s,"%s\t[",a);
+  for (i=0; i<l; i++) s+=sprintf(s,"%3d",ca[i]);
+  s+=sprintf(s," ]\n%s\t[",b);
+  for (i=0; i<l; i++) s+=sprintf(s,"%3d",cb[i]);
+  s+=sprintf(s," ]\n\n");
+  return s;
+}
+
+/**
+ * @brief Print a Legendre pair (see Pairformat).
+ *
+ * @param[in,out] fp output stream
+ * @param[in] a A string as text
+ * @param[in] ca correlations of the A string
+ * @param[in] b B string as text
+ * @param[in] cb correlations of the B string
+ * @param[in] l number of correlations
+ */
+void Pairprint(FILE *fp, const char *a, const signed char *ca, const char *b,
+               const signed char *cb, unsigned l)
+{
+  char s[PAIRSIZE(2*l)];
+  fwrite(s,1,(size_t)(Pairformat(s,a,ca,b,cb,l)-s),fp);
+}
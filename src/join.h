@@ -0,0 +1,38 @@
+/**
+ * @file join.h
+ * @brief Hash join of A and B strings on their correlations declarations.
+ * @author Thomas Pender
+ */
+# ifndef JOIN_H
+# define JOIN_H
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+
+/**
+ * @brief Bound on the size of a Legendre pair of strings of length \b n as
+ * printed by Pairprint (correlations of at most 4 characters, n/2 of them;
+ * PAIRSIZE(2m) for m correlations of strings no longer than 2m).
+ */
+# define PAIRSIZE(n) (2*((n)+2+4*((n)/2)+3)+2)
+
+/** @brief Hash table of strings keyed on their correlations (see join.c). */
+typedef struct join join_t;
+
+join_t *Joininit(unsigned, unsigned);
+void Joinadd(join_t*, const signed char*, const char*);
+void Joinaddref(join_t*, const signed char*, size_t);
+size_t Joinfind(const join_t*, const signed char*);
+const char *Joinseq(const join_t*, size_t, size_t*);
+size_t Joinref(const join_t*, size_t, size_t*);
+size_t Joinsize(const join_t*);
+void Joinmerge(join_t*, const join_t*);
+void Joinfree(join_t*);
+void Joincomplement(const signed char*, signed char*, unsigned);
+char *Pairformat(char*, const char*, const signed char*, const char*,
+                 const signed char*, unsigned);
+void Pairprint(FILE*, const char*, const signed char*, const char*,
+               const signed char*, unsigned);
+
+# endif
@@ -8,5 +8,8 @@
 
 # include <seq_funcs.h>
 # include <bracelets.h>
+# include <search.h>
+# include <classes.h>
+# include <estimate.h>
 
 # endif
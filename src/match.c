@@ -0,0 +1,385 @@
+/**
+ * @file match.c
+ *
+ * @brief Search the outputs of A and B for quaternary Legendre pairs.
+ *
+ * The strings of the smaller file are loaded into a hash table keyed on their
+ * correlations (see join.c). The larger file is streamed, and every string is
+ * looked up under the complement -2 - R of its correlations R. Memory is
+ * proportional to the smaller file, and nothing is sorted. Both files are
+ * mapped and parsed in place (see records.c): the table holds the offsets of
+ * the strings in the mapping rather than copies, and the strings are decoded
+ * only for the pairs printed.
+ *
+ * The join runs on a pool of workers (see pool.c). Keys are hash partitioned
+ * on their first PREFIX correlations, the smaller file on R and the larger
+ * one on -2 - R, so that partners fall into the same partition. The workers
+ * read parts of the smaller file concurrently (see Readerparts) and sort its
+ * strings into the partitions, build the tables of the partitions
+ * independently, then read parts of the larger file and probe the table of
+ * the partition of every string. Each worker writes its pairs through a
+ * buffer of its own, merged into stdout by the writer (see output.c).
+ * Files that cannot be mapped (pipes) are joined by a single thread.
+ *
+ * With <b><tt>-m</tt></b>, neither file is held in memory: both are split into
+ * sorted runs on disk (see extsort.c), A keyed on its correlations R and B on
+ * -2 - R, and the two sorted streams are merge joined. Only the B strings
+ * sharing the current key are kept in memory.
+ *
+ * Executable usage: <b><tt>./match [-j threads] [-m megabytes] <A_out_file>
+ * <B_out_file> 1> <legendre_pairs></tt></b> <br>
+ * - <b><tt>-j threads</tt></b> number of worker threads of the hash join
+ * (default: number of online processors).
+ * - <b><tt>-m megabytes</tt></b> sort-merge with a memory budget of about
+ * that many megabytes (split between the two files), for inputs larger than
+ * memory.
+ * - <b><tt><A_out_file></tt></b> and <b><tt><B_out_file></tt></b> are the
+ * outputs of A and B, as text or binary records (see BINRECORD), or those of
+ * <b><tt>U -k A</tt></b> and <b><tt>U -k B</tt></b>. Their strings are joined
+ * on all of their correlations, N/2 or N-1 of them (see argcomplex). Either
+ * file may be "-" for stdin, which is then streamed as the larger side.
+ * - The Legendre pairs are written to stdout in the format of
+ * <b><tt>ordered_check_sums</tt></b>, though in no particular order.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdbool.h>
+# include <string.h>
+# include <unistd.h>
+# include <libgen.h>
+# include <error.h>
+# include <errno.h>
+# include <stdint.h>
+# include <sys/stat.h>
+
+/* project headers */
+# include <records.h>
+# include <join.h>
+# include <extsort.h>
+# include <output.h>
+# include <pool.h>
+
+# define PREFIX 4             ///< number of correlations picking the partition
+# define PARTS_PER_THREAD 4   ///< number of parts of a file per worker thread
+# define PARTITIONS_PER_THREAD 16 ///< number of partitions per worker thread
+
+/** @cond */
+
+typedef struct {
+  unsigned char *data; /* entries: reference of a string, then its key */
+  size_t len, cap;     /* in bytes */
+} bucket_t;
+
+typedef struct {
+  reader_t *small;      /* indexed side */
+  bool Asmall;
+  unsigned n, l;
+  unsigned nthreads;
+  unsigned npartitions; /* a power of 2 */
+  bucket_t *buckets;    /* partition p read by worker w: w*npartitions+p */
+  join_t **joins;       /* table of every partition */
+  writer_t *W;
+} pjoin_t;
+
+/* size of a regular file, -1 for stdin ("-") and other streams */
+static
+off_t filesize(const char *file)
+{
+  struct stat st;
+  if (strcmp(file,"-")==0) return -1;
+  if (stat(file,&st)!=0) error(1, errno, "failed to stat %s", file);
+  return S_ISREG(st.st_mode) ? st.st_size : -1;
+}
+
+/* string s of the table of the smaller side */
+static inline
+const char *tableseq(const join_t *J, const reader_t *R, size_t s, size_t *next,
+                     char *seq)
+{
+  if (!Readermapped(R)) return Joinseq(J,s,next);
+  Readerseq(R,Joinref(J,s,next),seq);
+  return seq;
+}
+
+/* partition of a key */
+static inline
+unsigned partition(const signed char *key, unsigned l, unsigned mask)
+{
+  uint32_t h=UINT32_C(2166136261); /* FNV-1a */
+  for (unsigned i=0; i<PREFIX && i<l; i++) {
+    h^=(unsigned char)key[i];
+    h*=UINT32_C(16777619);
+  }
+  return (unsigned)(h^(h>>16U))&mask;
+}
+
+/* sort a part of the smaller side into the buckets of worker w (task) */
+static
+void scanpart(void *task, unsigned w, void *_M)
+{
+  pjoin_t *M=(pjoin_t*)_M;
+  reader_t *R=(reader_t*)task;
+  bucket_t *b, *B=M->buckets+(size_t)w*M->npartitions;
+  size_t r, es=sizeof(size_t)+M->l;
+  signed char key[M->l];
+
+  while ( (r=Readerscan(R,key))!=0 ) {
+    b=B+partition(key,M->l,M->npartitions-1);
+    if (b->len+es>b->cap) {
+      b->cap=b->cap==0 ? 64*es : 2*b->cap;
+      if ( (b->data=(unsigned char*)realloc(b->data,b->cap))==NULL )
+        error(1, errno, "realloc failed");
+    }
+    memcpy(b->data+b->len,&r,sizeof(size_t));
+    memcpy(b->data+b->len+sizeof(size_t),key,M->l);
+    b->len+=es;
+  }
+}
+
+/* build the table of a partition from the buckets of every worker (task) */
+static
+void buildpartition(void *task, unsigned w, void *_M)
+{
+  pjoin_t *M=(pjoin_t*)_M;
+  join_t **J=(join_t**)task;
+  size_t p=(size_t)(J-M->joins), i, r, es=sizeof(size_t)+M->l;
+  bucket_t *b;
+
+  (void)w;
+  *J=Joininit(0,M->l);
+  for (unsigned t=0; t<M->nthreads; t++) {
+    b=M->buckets+(size_t)t*M->npartitions+p;
+    for (i=0; i<b->len; i+=es) {
+      memcpy(&r,b->data+i,sizeof(size_t));
+      Joinaddref(*J,(const signed char*)b->data+i+sizeof(size_t),r);
+    }
+    free(b->data);
+  }
+}
+
+/* probe the tables with a part of the larger side (task) */
+static
+void probepart(void *task, unsigned w, void *_M)
+{
+  pjoin_t *M=(pjoin_t*)_M;
+  reader_t *R=(reader_t*)task;
+  outbuf_t *O=Writerbuf(M->W,w);
+  const unsigned n=M->n, l=M->l;
+  char seq[n+1], t[n+1], *e;
+  signed char corrs[l], comp[l];
+  size_t r, s, next;
+  join_t *J;
+
+  while ( (r=Readerscan(R,corrs))!=0 ) {
+    Joincomplement(corrs,comp,l);
+    J=M->joins[partition(comp,l,M->npartitions-1)];
+    if ( (s=Joinfind(J,comp))==0 ) continue;
+    Readerseq(R,r,seq);
+    for (; s!=0; s=next) {
+      Readerseq(M->small,Joinref(J,s,&next),t);
+      e=Outreserve(O,PAIRSIZE(2*l));
+      if (M->Asmall) Outcommit(O,Pairformat(e,t,comp,seq,corrs,l));
+      else Outcommit(O,Pairformat(e,seq,corrs,t,comp,l));
+    }
+  }
+}
+
+/* run a task per part of a mapped file on a pool */
+static
+void partsrun(const reader_t *R, pjoin_t *M, task_func_t func)
+{
+  const unsigned m=PARTS_PER_THREAD*M->nthreads;
+  reader_t **parts=Readerparts(R,m);
+  pool_t *P=Poolinit(M->nthreads,func,M);
+  unsigned i;
+
+  for (i=0; i<m; i++) Poolpush(P,i%M->nthreads,parts[i]);
+  Poolrun(P);
+  Poolfree(P);
+  for (i=0; i<m; i++) Readerclose(parts[i]);
+  free(parts);
+}
+
+/* partitioned hash join of two mapped files */
+static
+void parmatch(reader_t *small, reader_t *large, bool Asmall, unsigned nthreads)
+{
+  pjoin_t M={.small=small,.Asmall=Asmall,.n=Readerlength(small),
+             .l=Readercorrs(small),.nthreads=nthreads,.npartitions=1};
+  pool_t *P;
+  unsigned p;
+
+  while (M.npartitions<PARTITIONS_PER_THREAD*nthreads) M.npartitions*=2;
+  M.buckets=(bucket_t*)calloc((size_t)nthreads*M.npartitions,sizeof(bucket_t));
+  M.joins=(join_t**)malloc(M.npartitions*sizeof(join_t*));
+  if (M.buckets==NULL || M.joins==NULL) error(1, errno, "malloc failed");
+
+  /* partition the smaller side, then index every partition */
+  partsrun(small,&M,scanpart);
+  P=Poolinit(nthreads,buildpartition,&M);
+  for (p=0; p<M.npartitions; p++) Poolpush(P,p%nthreads,M.joins+p);
+  Poolrun(P);
+  Poolfree(P);
+  free(M.buckets);
+
+  /* probe with the larger side */
+  M.W=Writerinit(stdout,nthreads);
+  partsrun(large,&M,probepart);
+  Writerfree(M.W);
+  for (p=0; p<M.npartitions; p++) Joinfree(M.joins[p]);
+  free(M.joins);
+}
+
+/* merge join of A and B sorted on R and -2 - R respectively */
+static
+void extmatch(const char *Afile, const char *Bfile, size_t budget)
+{
+  reader_t *RA=Readeropen(Afile), *RB=Readeropen(Bfile);
+  runs_t *SA, *SB;
+  unsigned n, l;
+  size_t i, ngroup=0, groupcap=0;
+  char *group=NULL; /* B strings of the current key, n+1 bytes each */
+  bool moreA, moreB;
+  int c;
+
+  if ( (n=Readerlength(RA))==0 || Readerlength(RB)==0 ) exit(0);
+  if (Readerlength(RB)!=n) error(1, 0, "string lengths differ");
+  if ( (l=Readercorrs(RA))!=Readercorrs(RB) )
+    error(1, 0, "numbers of correlations differ");
+
+  char a[n+1], b[n+1];
+  signed char ka[l], kb[l], key[l], cb[l];
+
+  SA=Runsplit(RA,budget/2,false);
+  Readerclose(RA);
+  SB=Runsplit(RB,budget/2,true);
+  Readerclose(RB);
+
+  moreA=Runsnext(SA,ka,a);
+  moreB=Runsnext(SB,kb,b);
+  while (moreA && moreB) {
+    if ( (c=memcmp(ka,kb,l))<0 ) moreA=Runsnext(SA,ka,a);
+    else if (c>0) moreB=Runsnext(SB,kb,b);
+    else {
+      /* gather the B strings of this key, then pair every A string with it */
+      memcpy(key,kb,l);
+      ngroup=0;
+      do {
+        if (ngroup==groupcap) {
+          groupcap=groupcap==0 ? 64 : 2*groupcap;
+          if ( (group=(char*)realloc(group,groupcap*(n+1)))==NULL )
+            error(1, errno, "realloc failed");
+        }
+        memcpy(group+ngroup++*(n+1),b,n+1);
+      } while ( (moreB=Runsnext(SB,kb,b)) && memcmp(kb,key,l)==0 );
+      Joincomplement(key,cb,l);
+      do
+        for (i=0; i<ngroup; i++)
+          Pairprint(stdout,a,key,group+i*(n+1),cb,l);
+      while ( (moreA=Runsnext(SA,ka,a)) && memcmp(ka,key,l)==0 );
+    }
+  }
+  if (group!=NULL) free(group);
+  Runsfree(SA);
+  Runsfree(SB);
+}
+
+/** @endcond */
+
+/**
+ * @brief driver
+ * @param[in] A_out_file output of A
+ * @param[in] B_out_file output of B
+ */
+int main(int argc, char **argv)
+{
+  reader_t *small, *large;
+  join_t *J;
+  bool Asmall;
+  off_t sa, sb;
+  unsigned n, l, mb=0, nthreads;
+  long nprocs=sysconf(_SC_NPROCESSORS_ONLN);
+  size_t s, next, r;
+  int opt;
+
+  nthreads=nprocs>0 ? (unsigned)nprocs : 1;
+  while ( (opt=getopt(argc,argv,"j:m:")) != -1) {
+    switch (opt) {
+    case 'j':
+      if (sscanf(optarg,"%u",&nthreads)!=1 || nthreads==0)
+        error(1, 0, "<threads> must be a positive integer");
+      break;
+    case 'm':
+      if (sscanf(optarg,"%u",&mb)!=1 || mb==0)
+        error(1, 0, "<megabytes> must be a positive integer");
+      break;
+    default:
+      error(1, 0, "usage -- %s [-j threads] [-m megabytes] <A_out_file> "
+            "<B_out_file>", basename(argv[0]));
+    }
+  }
+  if (optind!=argc-2)
+    error(1, 0, "usage -- %s [-j threads] [-m megabytes] <A_out_file> "
+          "<B_out_file>", basename(argv[0]));
+  argv+=optind-1;
+# if !HAVE_PTHREAD
+  nthreads=1;
+# endif
+
+  if (mb>0) {
+    extmatch(argv[1],argv[2],(size_t)mb<<20U);
+    exit(0);
+  }
+
+  /* index the smaller side; a stream is read once, as the larger side */
+  sa=filesize(argv[1]);
+  sb=filesize(argv[2]);
+  Asmall=sa>=0 && (sb<0 || sa<=sb);
+  small=Readeropen(argv[Asmall ? 1 : 2]);
+  large=Readeropen(argv[Asmall ? 2 : 1]);
+  if ( (n=Readerlength(small))==0 || Readerlength(large)==0 ) exit(0);
+  if (Readerlength(large)!=n) error(1, 0, "string lengths differ");
+  if ( (l=Readercorrs(small))!=Readercorrs(large) )
+    error(1, 0, "numbers of correlations differ");
+
+  if (Readermapped(small) && Readermapped(large)) {
+    parmatch(small,large,Asmall,nthreads);
+    Readerclose(large);
+    Readerclose(small);
+    exit(0);
+  }
+
+  char seq[n+1], buf[n+1];
+  signed char corrs[l], comp[l];
+
+  if (Readermapped(small)) {
+    J=Joininit(0,l);
+    while ( (r=Readerscan(small,corrs))!=0 ) Joinaddref(J,corrs,r);
+  }
+  else {
+    J=Joininit(n,l);
+    while (Readernext(small,seq,corrs)) Joinadd(J,corrs,seq);
+  }
+
+  /* stream the larger side */
+  while ( (r=Readerscan(large,corrs))!=0 ) {
+    Joincomplement(corrs,comp,l);
+    if ( (s=Joinfind(J,comp))==0 ) continue;
+    Readerseq(large,r,seq);
+    for (; s!=0; s=next) {
+      const char *t=tableseq(J,small,s,&next,buf);
+      if (Asmall) Pairprint(stdout,t,comp,seq,corrs,l);
+      else Pairprint(stdout,seq,corrs,t,comp,l);
+    }
+  }
+  Readerclose(large);
+  Readerclose(small);
+  Joinfree(J);
+  exit(0);
+}
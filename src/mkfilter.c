@@ -0,0 +1,88 @@
+/**
+ * @file mkfilter.c
+ *
+ * @brief Build a filter of the correlations of an A or B output.
+ *
+ * The correlation vectors of the output are stored in a Bloom filter (see
+ * bloom.c). A search given the filter with <b><tt>-f</tt></b> drops the
+ * strings whose complement -2 - R of their correlations R is certainly not in
+ * it, i.e. those without a partner in the output.
+ *
+ * Executable usage: <b><tt>./mkfilter [-r rate] <out_file> 1>
+ * <filter_file></tt></b> <br>
+ * - <b><tt><out_file></tt></b> is an output of A or B, as text or binary
+ * records ("-" for stdin).
+ * - <b><tt><rate></tt></b> is the false positive rate the filter is sized
+ * for (default: 0.01).
+ * - The filter is written to stdout.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <string.h>
+# include <unistd.h>
+# include <libgen.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <records.h>
+# include <bloom.h>
+
+/**
+ * @brief driver
+ * @param[in] out_file output of A or B
+ */
+int main(int argc, char **argv)
+{
+  reader_t *R;
+  bloom_t *F;
+  signed char *keys=NULL;
+  size_t i, nkeys=0, cap=0;
+  double rate=0.01;
+  unsigned n, l;
+  int opt;
+
+  while ( (opt=getopt(argc,argv,"r:")) != -1) {
+    switch (opt) {
+    case 'r':
+      if (sscanf(optarg,"%lf",&rate)!=1 || !(rate>0 && rate<1))
+        error(1, 0, "<rate> must lie strictly between 0 and 1");
+      break;
+    default:
+      error(1, 0, "usage -- %s [-r rate] <out_file>", basename(argv[0]));
+    }
+  }
+  if (optind!=argc-1)
+    error(1, 0, "usage -- %s [-r rate] <out_file>", basename(argv[0]));
+
+  R=Readeropen(argv[optind]);
+  if ( (n=Readerlength(R))==0 ) error(1, 0, "%s is empty", argv[optind]);
+  if ( (l=n/2)!=Readercorrs(R) )
+    error(1, 0, "%s -- filters hold real correlations only", argv[optind]);
+
+  /* the filter is sized by the number of vectors, so they are read first */
+  char seq[n+1];
+  signed char corrs[l];
+  while (Readernext(R,seq,corrs)) {
+    if (nkeys==cap) {
+      cap=cap==0 ? 4096 : 2*cap;
+      if ( (keys=(signed char*)realloc(keys,cap*l))==NULL )
+        error(1, errno, "realloc failed");
+    }
+    memcpy(keys+nkeys++*l,corrs,l);
+  }
+  Readerclose(R);
+
+  F=Bloominit(n,nkeys,rate);
+  for (i=0; i<nkeys; i++) Bloomadd(F,keys+i*l);
+  Bloomwrite(F,stdout);
+  Bloomfree(F);
+  if (keys!=NULL) free(keys);
+  exit(0);
+}
@@ -3,6 +3,7 @@ package main
 import (
 	"bufio"
 	"fmt"
+	"io"
 	"log"
 	"os"
 	"sort"
@@ -31,15 +32,26 @@ func (c corrs) Less(i, j int) bool {
 }
 func (c corrs) Swap(i, j int) { c[i], c[j] = c[j], c[i] }
 
+const (
+	binMagic  = "LPQB" // magic of binary record files (see src/output.h)
+	binHeader = 8      // size of the header of binary record files
+)
+
 func fileToMap(file string) map[string][]string {
 	f, err := os.Open(file)
 	if err != nil {
 		log.Fatalf("fileToMap -- failed to open file %s", file)
 	}
+	defer f.Close()
+
+	r := bufio.NewReaderSize(f, 1<<20)
+	if magic, err := r.Peek(len(binMagic)); err == nil && string(magic) == binMagic {
+		return binToMap(r)
+	}
 
 	keys := make(map[string][]string)
 
-	input := bufio.NewScanner(f)
+	input := bufio.NewScanner(r)
 	for input.Scan() {
 		x := strings.Split(input.Text(), " ")
 		if len(x) < 2 {
@@ -48,7 +60,49 @@ func fileToMap(file string) map[string][]string {
 		keys[x[1]] = append(keys[x[1]], x[0])
 	}
 
-	f.Close()
+	return keys
+}
+
+/* binary records: content class, 2-bit packed string, signed byte correlations */
+func binToMap(r *bufio.Reader) map[string][]string {
+	hdr := make([]byte, binHeader)
+	if _, err := io.ReadFull(r, hdr); err != nil {
+		log.Fatalf("binToMap -- truncated header")
+	}
+	n := int(hdr[5]) | int(hdr[6])<<8
+	nb, l := (n+3)/4, n/2
+
+	keys := make(map[string][]string)
+
+	rec := make([]byte, 1+nb+l)
+	seq := make([]byte, n)
+	key := make([]byte, 0, 4*l)
+	for {
+		/* header of a concatenated file (records start with a class < 'L') */
+		if b, err := r.Peek(1); err == nil && b[0] == binMagic[0] {
+			if _, err := io.ReadFull(r, hdr); err != nil || int(hdr[5])|int(hdr[6])<<8 != n {
+				log.Fatalf("binToMap -- malformed header")
+			}
+			continue
+		}
+		if _, err := io.ReadFull(r, rec); err != nil {
+			if err == io.EOF {
+				break
+			}
+			log.Fatalf("binToMap -- truncated record")
+		}
+		for i := 0; i < n; i++ {
+			seq[i] = '0' + (rec[1+(i>>2)]>>(2*(i&3)))&3
+		}
+		key = key[:0]
+		for i := 0; i < l; i++ {
+			if i > 0 {
+				key = append(key, ',')
+			}
+			key = strconv.AppendInt(key, int64(int8(rec[1+nb+i])), 10)
+		}
+		keys[string(key)] = append(keys[string(key)], string(seq))
+	}
 
 	return keys
 }
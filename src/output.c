@@ -0,0 +1,287 @@
+/**
+ * @file output.c
+ * @brief Buffered output writer.
+ *
+ * Every worker formats its lines into a block of its own output buffer. Full
+ * blocks are queued to a dedicated writer thread, and the worker carries on
+ * with the second block of its buffer. Blocks only ever hold whole lines, so
+ * the output stays line-atomic without taking a lock per line, and nothing is
+ * flushed before a block is full.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <output.h>
+
+# if HAVE_PTHREAD
+# include <pthread.h>
+# endif
+
+/** @cond */
+
+struct writer {
+  FILE *fp;
+  unsigned nbufs;
+  outbuf_t *bufs;
+# if HAVE_PTHREAD
+  outblock_t *head, *tail; /* queue of blocks waiting to be written */
+  int done;
+  pthread_t thread;
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+# endif
+};
+
+static
+void blockwrite(FILE *fp, outblock_t *B)
+{
+  if (fwrite(B->data,1,B->len,fp)!=B->len)
+    error(1, errno, "fwrite failed");
+}
+
+# if HAVE_PTHREAD
+static
+void *writer(void *_W)
+{
+  writer_t *W=(writer_t*)_W;
+  outblock_t *B;
+
+  pthread_mutex_lock(&W->mtx);
+  for (;;) {
+    while (W->head==NULL && !W->done) pthread_cond_wait(&W->cond,&W->mtx);
+    if ( (B=W->head)==NULL ) break;
+    if ( (W->head=B->next)==NULL ) W->tail=NULL;
+    pthread_mutex_unlock(&W->mtx);
+
+    blockwrite(W->fp,B);
+
+    pthread_mutex_lock(&W->mtx);
+    B->len=0;
+    B->busy=0;
+    pthread_cond_broadcast(&W->cond);
+  }
+  pthread_mutex_unlock(&W->mtx);
+  return NULL;
+}
+# endif
+
+/* hand the current block to the writer and switch to the other one */
+static
+void blocksubmit(outbuf_t *O)
+{
+  outblock_t *B=&O->blk[O->cur];
+  if (B->len==0) return;
+# if HAVE_PTHREAD
+  writer_t *W=O->W;
+  pthread_mutex_lock(&W->mtx);
+  B->busy=1;
+  B->next=NULL;
+  if (W->tail!=NULL) W->tail->next=B;
+  else W->head=B;
+  W->tail=B;
+  pthread_cond_broadcast(&W->cond);
+
+  O->cur^=1U;
+  while (O->blk[O->cur].busy) pthread_cond_wait(&W->cond,&W->mtx);
+  pthread_mutex_unlock(&W->mtx);
+# else
+  blockwrite(O->W->fp,B);
+  B->len=0;
+# endif
+}
+
+/** @endcond */
+
+/**
+ * @brief Create an output writer.
+ *
+ * @param[in] fp output stream
+ * @param[in] nbufs number of worker output buffers
+ *
+ * @retval writer Return the writer (finish with Writerfree).
+ */
+writer_t *Writerinit(FILE *fp, unsigned nbufs)
+{
+  writer_t *W;
+  if ( (W=(writer_t*)malloc(sizeof(writer_t)))==NULL )
+    error(1, errno, "Writerinit -- malloc failed");
+  W->fp=fp;
+  W->nbufs=nbufs;
+  if ( (W->bufs=(outbuf_t*)calloc(nbufs,sizeof(outbuf_t)))==NULL )
+    error(1, errno, "Writerinit -- calloc failed");
+  for (unsigned i=0; i<nbufs; i++) {
+    W->bufs[i].W=W;
+    for (unsigned j=0; j<2; j++)
+      if ( (W->bufs[i].blk[j].data=(char*)malloc(OUTBLOCK))==NULL )
+        error(1, errno, "Writerinit -- malloc failed");
+  }
+# if HAVE_PTHREAD
+  int throw;
+  W->head=W->tail=NULL;
+  W->done=0;
+  pthread_mutex_init(&W->mtx,NULL);
+  pthread_cond_init(&W->cond,NULL);
+  if ( (throw=pthread_create(&W->thread,NULL,writer,W)) != 0)
+    error(1, throw, "pthread_create failed");
+# endif
+  return W;
+}
+
+/**
+ * @brief Output buffer of a worker.
+ *
+ * A buffer must only be used by one thread at a time.
+ *
+ * @param[in] W writer
+ * @param[in] i worker index
+ *
+ * @retval buffer Return the output buffer of worker <b><tt>i</tt></b>.
+ */
+outbuf_t *Writerbuf(writer_t *W, unsigned i)
+{
+  return &W->bufs[i%W->nbufs];
+}
+
+/**
+ * @brief Write out every buffer and flush the output stream.
+ *
+ * Returns once everything formatted so far is in the stream. Must not be
+ * called while workers use their buffers.
+ *
+ * @param[in,out] W writer
+ */
+void Writerflush(writer_t *W)
+{
+  unsigned i;
+  for (i=0; i<W->nbufs; i++) blocksubmit(&W->bufs[i]);
+# if HAVE_PTHREAD
+  pthread_mutex_lock(&W->mtx);
+  for (i=0; i<W->nbufs; i++)
+    while (W->bufs[i].blk[0].busy || W->bufs[i].blk[1].busy)
+      pthread_cond_wait(&W->cond,&W->mtx);
+  pthread_mutex_unlock(&W->mtx);
+# endif
+  if (fflush(W->fp)!=0) error(1, errno, "fflush failed");
+}
+
+/**
+ * @brief Write out every buffer and free the writer.
+ *
+ * Must not be called while workers still use their buffers.
+ *
+ * @param[in,out] W writer
+ */
+void Writerfree(writer_t *W)
+{
+  unsigned i;
+  for (i=0; i<W->nbufs; i++) blocksubmit(&W->bufs[i]);
+# if HAVE_PTHREAD
+  int throw;
+  pthread_mutex_lock(&W->mtx);
+  W->done=1;
+  pthread_cond_broadcast(&W->cond);
+  pthread_mutex_unlock(&W->mtx);
+  if ( (throw=pthread_join(W->thread,NULL)) != 0)
+    error(1, throw, "pthread_join failed");
+  pthread_mutex_destroy(&W->mtx);
+  pthread_cond_destroy(&W->cond);
+# endif
+  if (fflush(W->fp)!=0) error(1, errno, "fflush failed");
+  for (i=0; i<W->nbufs; i++) {
+    free(W->bufs[i].blk[0].data);
+    free(W->bufs[i].blk[1].data);
+  }
+  free(W->bufs);
+  free(W);
+}
+
+/**
+ * @brief Reserve room for a line.
+ *
+ * Hands the current block to the writer first if it has less than
+ * <b><tt>len</tt></b> bytes left.
+ *
+ * @param[in,out] O output buffer
+ * @param[in] len maximal length of the line
+ *
+ * @retval line Return where the line is to be formatted (see Outcommit).
+ */
+char *Outreserve(outbuf_t *O, size_t len)
+{
+  if (len>OUTBLOCK) error(1, 0, "Outreserve -- line exceeds the block size");
+  if (OUTBLOCK-O->blk[O->cur].len<len) blocksubmit(O);
+  return O->blk[O->cur].data+O->blk[O->cur].len;
+}
+
+/**
+ * @brief Complete a line formatted into reserved room (see Outreserve).
+ *
+ * @param[in,out] O output buffer
+ * @param[in] end end of the formatted line
+ */
+void Outcommit(outbuf_t *O, char *end)
+{
+  outblock_t *B=&O->blk[O->cur];
+  B->len=(size_t)(end-B->data);
+}
+
+/**
+ * @brief Write the header of a binary record file (see BINRECORD).
+ *
+ * @param[in,out] fp output stream
+ * @param[in] kind kind of the strings ('A' or 'B')
+ * @param[in] n string length
+ */
+void Binheader(FILE *fp, char kind, unsigned n)
+{
+  unsigned char hdr[BINHEADER]={BINMAGIC[0],BINMAGIC[1],BINMAGIC[2],
+                                BINMAGIC[3],(unsigned char)kind,
+                                (unsigned char)(n&0xffU),
+                                (unsigned char)(n>>8U),0};
+  if (fwrite(hdr,1,BINHEADER,fp)!=BINHEADER)
+    error(1, errno, "fwrite failed");
+}
+
+/**
+ * @brief Read the header of a binary record file (see BINRECORD).
+ *
+ * @param[in,out] fp input stream
+ * @param[out] kind kind of the strings (see BINRECORD)
+ * @param[out] n string length
+ *
+ * @retval valid Return whether the stream starts with a valid header.
+ */
+int Binheaderread(FILE *fp, char *kind, unsigned *n)
+{
+  unsigned char hdr[BINHEADER];
+  if (fread(hdr,1,BINHEADER,fp)!=BINHEADER) return 0;
+  return Binheaderparse(hdr,kind,n);
+}
+
+/**
+ * @brief Parse the header of a binary record file held in memory (see
+ * Binheaderread).
+ *
+ * @param[in] hdr the BINHEADER bytes of the header
+ * @param[out] kind kind of the strings (see BINRECORD)
+ * @param[out] n string length
+ *
+ * @retval valid Return whether the header is valid.
+ */
+int Binheaderparse(const unsigned char *hdr, char *kind, unsigned *n)
+{
+  for (size_t i=0; i<4; i++)
+    if (hdr[i]!=(unsigned char)BINMAGIC[i]) return 0;
+  *kind=(char)hdr[4];
+  *n=hdr[5]|((unsigned)hdr[6]<<8U);
+  return *n>0 && *n<=BINMAXN && !(*n&1U);
+}
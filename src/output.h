@@ -0,0 +1,70 @@
+/**
+ * @file output.h
+ * @brief Buffered output writer declarations.
+ * @author Thomas Pender
+ */
+# ifndef OUTPUT_H
+# define OUTPUT_H
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+
+# define OUTBLOCK (1U<<20) ///< size of an output block in bytes
+
+# define BINMAGIC "LPQB" ///< magic of binary record files
+# define BINHEADER 8     ///< size of the header of binary record files
+# define BINMAXN 127     ///< largest string length of binary records
+
+/**
+ * @brief Size of a binary record of strings of length \b n with \b m
+ * correlations.
+ *
+ * Binary record files start with a header of BINHEADER bytes: BINMAGIC, the
+ * kind of the strings ('A' or 'B', or 'a' or 'b' for unrestricted ones, see
+ * U.c), the string length as a 16 bit little endian integer and a zero byte.
+ * Every record then holds the content class (1 byte), the string packed to 2
+ * bits per letter (letter i in bits 2(i%4) of byte i/4, counting from 0) and
+ * the m correlations as signed bytes (see BINCORRS).
+ */
+# define BINRECORD(n,m) (1+((n)+3)/4+(m))
+
+/**
+ * @brief Number of correlations of the strings of a kind and length \b n:
+ * n/2, or n-1 for unrestricted strings (see argcomplex).
+ */
+# define BINCORRS(kind,n) ((kind)=='a' || (kind)=='b' ? (n)-1 : (n)/2)
+
+/** @brief Output writer (see output.c). */
+typedef struct writer writer_t;
+
+/** @brief Block of whole output lines. */
+typedef struct outblock {
+  char *data;            ///< formatted lines
+  size_t len;            ///< number of bytes in use
+  int busy;              ///< whether the block waits for the writer
+  struct outblock *next; ///< next block in the queue of the writer
+} outblock_t;
+
+/**
+ * @brief Output buffer of a single worker.
+ *
+ * Lines are formatted into one block while the other one is written out.
+ */
+typedef struct {
+  writer_t *W;       ///< owning writer
+  outblock_t blk[2]; ///< the two blocks of the buffer
+  unsigned cur;      ///< index of the block being filled
+} outbuf_t;
+
+writer_t *Writerinit(FILE*, unsigned);
+outbuf_t *Writerbuf(writer_t*, unsigned);
+void Writerflush(writer_t*);
+void Writerfree(writer_t*);
+char *Outreserve(outbuf_t*, size_t);
+void Outcommit(outbuf_t*, char*);
+void Binheader(FILE*, char, unsigned);
+int Binheaderread(FILE*, char*, unsigned*);
+int Binheaderparse(const unsigned char*, char*, unsigned*);
+
+# endif
@@ -0,0 +1,76 @@
+/**
+ * @file pairs.c
+ *
+ * @brief Search for quaternary Legendre pairs in a single process.
+ *
+ * The B search is run first, into a hash table of its strings keyed on their
+ * correlations (see Searchindex). The A search is then run, and every A string
+ * passing the checks is looked up under the complement -2 - R of its
+ * correlations R as it is found (see pairseq). Only the Legendre pairs are
+ * written; no A or B output is formatted, written or read back. Memory is
+ * proportional to the output of B.
+ *
+ * Executable usage: <b><tt>./pairs [-u] [-o out_file] [-s i/m] [-p seconds]
+ * [-t stats_file] [-j threads] [-d depth] <length> 1> <legendre_pairs></tt></b>
+ * <br>
+ * - <b><tt><length></tt></b> is a positive even integer denoting the length of
+ * the strings (at most 127).
+ * - <b><tt><threads></tt></b> is the number of worker threads (default: number
+ * of online processors).
+ * - <b><tt><depth></tt></b> is the prefix length at which the bracelet
+ * recursion is split into tasks (default: chosen automatically).
+ * - <b><tt>-u</tt></b> reduces both searches by their symmetries (see A.c
+ * and B.c): only one Legendre pair of every orbit is written.
+ * - <b><tt>-s i/m</tt></b> matches only the i-th of m shards of the A search
+ * (see A.c); every shard indexes all of B.
+ * - <b><tt>-p</tt></b> and <b><tt>-t</tt></b> report progress and write
+ * summaries as for A (see A.c), for the B and A searches in turn.
+ * - The Legendre pairs are written to stdout (or <b><tt>out_file</tt></b>) in
+ * the format of <b><tt>ordered_check_sums</tt></b>, though in no particular
+ * order.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stdlib.h>
+# include <error.h>
+
+/* project headers */
+# include <defs.h>
+# include <legendre.h>
+# include <join.h>
+
+/**
+ * @brief driver
+ * @param[in] N Length of strings. Required to be even.
+ */
+int main(int argc, char **argv)
+{
+  search_t S={.classinit=Bclassinit,.kind='B'};
+  unsigned depth;
+
+  Searchopts(argc,argv,&S);
+  if (S.binary) error(1, 0, "Legendre pairs are written as text only");
+  if (S.filter!=NULL) error(1, 0, "filters do not apply to pair searches");
+  if (S.ckpt>0) error(1, 0, "checkpoints do not apply to pair searches");
+  if (S.probes>0) error(1, 0, "estimates apply to A and B only");
+  if (S.n>BINMAXN) error(1, 0, "<length> must be at most %d", BINMAXN);
+  depth=S.depth;
+
+  /* index B */
+  S.nclasses=S.reduce ? Bsymclasses(S.n) : Bclasses(S.n);
+  S.join=Searchindex(&S);
+
+  /* match A as it is found */
+  S.classinit=Aclassinit;
+  S.kind='A';
+  S.nclasses=Aclasses(S.n);
+  S.depth=depth;
+  Search(&S);
+
+  Joinfree(S.join);
+  exit(0);
+}
@@ -0,0 +1,341 @@
+/**
+ * @file pool.c
+ * @brief Work-stealing thread pool.
+ *
+ * Every worker owns a double-ended queue of tasks. A worker takes tasks from
+ * the bottom of its own queue and, once it runs dry, steals from the top of the
+ * queues of the other workers. Tasks may be pushed before or while the pool
+ * runs; the pool returns once every pushed task has been completed.
+ *
+ * A method may be run periodically while every worker is paused between two
+ * tasks (see Poolperiodic), e.g. to take a consistent checkpoint of the tasks
+ * completed so far.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdbool.h>
+# include <time.h>
+# include <error.h>
+
+/* project headers */
+# include <pool.h>
+
+# if HAVE_PTHREAD
+# include <pthread.h>
+# endif
+
+/** @cond */
+
+typedef struct {
+  void **tasks;
+  size_t top, bot, cap; /* queued tasks are tasks[top..bot-1] */
+# if HAVE_PTHREAD
+  pthread_mutex_t mtx;
+# endif
+} deque_t;
+
+struct pool {
+  unsigned nworkers;
+  task_func_t func;
+  void *ctx;
+  deque_t *deques;
+  pause_func_t pausefunc; /* periodic method (see Poolperiodic), or NULL */
+  double interval, next;  /* period and next time of pausefunc in seconds */
+# if HAVE_PTHREAD
+  unsigned long pending, gen;
+  unsigned live, parked;  /* running workers, workers waiting for a pause */
+  bool pause;
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+# endif
+};
+
+typedef struct {
+  pool_t *P;
+  unsigned w;
+} worker_t;
+
+static inline
+void dequelock(deque_t *D)
+{
+# if HAVE_PTHREAD
+  pthread_mutex_lock(&D->mtx);
+# else
+  (void)D;
+# endif
+}
+
+static inline
+void dequeunlock(deque_t *D)
+{
+# if HAVE_PTHREAD
+  pthread_mutex_unlock(&D->mtx);
+# else
+  (void)D;
+# endif
+}
+
+static
+void dequepush(deque_t *D, void *task)
+{
+  dequelock(D);
+  if (D->bot==D->cap) {
+    if (D->top>0) { /* reclaim the stolen slots */
+      for (size_t i=D->top; i<D->bot; i++) D->tasks[i-D->top]=D->tasks[i];
+      D->bot-=D->top;
+      D->top=0;
+    }
+    if (D->bot==D->cap) {
+      D->cap=D->cap==0 ? 64 : 2*D->cap;
+      D->tasks=(void**)realloc(D->tasks,D->cap*sizeof(void*));
+      if (D->tasks==NULL) error(1, 0, "Poolpush -- realloc failed");
+    }
+  }
+  D->tasks[D->bot++]=task;
+  dequeunlock(D);
+}
+
+static
+bool dequepop(deque_t *D, void **task)
+{
+  bool flag=false;
+  dequelock(D);
+  if (D->bot>D->top) {
+    *task=D->tasks[--D->bot];
+    flag=true;
+  }
+  dequeunlock(D);
+  return flag;
+}
+
+static
+bool dequesteal(deque_t *D, void **task)
+{
+  bool flag=false;
+  dequelock(D);
+  if (D->bot>D->top) {
+    *task=D->tasks[D->top++];
+    flag=true;
+  }
+  dequeunlock(D);
+  return flag;
+}
+
+static inline
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+1e-9*(double)ts.tv_nsec;
+}
+
+static
+bool poolget(pool_t *P, unsigned w, void **task)
+{
+  if (dequepop(&P->deques[w],task)) return true;
+  for (unsigned i=1; i<P->nworkers; i++)
+    if (dequesteal(&P->deques[(w+i)%P->nworkers],task)) return true;
+  return false;
+}
+
+# if HAVE_PTHREAD
+/* run pausefunc once every other worker waits at the top of its loop;
+   called with P->mtx held */
+static
+void poolpause(pool_t *P)
+{
+  P->pause=true;
+  pthread_cond_broadcast(&P->cond);
+  while (P->parked+1<P->live) pthread_cond_wait(&P->cond,&P->mtx);
+  pthread_mutex_unlock(&P->mtx);
+  P->pausefunc(P->ctx);
+  pthread_mutex_lock(&P->mtx);
+  P->next=now()+P->interval;
+  P->pause=false;
+  pthread_cond_broadcast(&P->cond);
+}
+
+static
+void *poolworker(void *_worker)
+{
+  worker_t *W=(worker_t*)_worker;
+  pool_t *P=W->P;
+  unsigned long gen;
+  void *task;
+
+  for (;;) {
+    pthread_mutex_lock(&P->mtx);
+    if (P->pause) { /* between two tasks: wait for the pause to end */
+      P->parked++;
+      pthread_cond_broadcast(&P->cond);
+      while (P->pause) pthread_cond_wait(&P->cond,&P->mtx);
+      P->parked--;
+    }
+    gen=P->gen;
+    pthread_mutex_unlock(&P->mtx);
+
+    if (poolget(P,W->w,&task)) {
+      P->func(task,W->w,P->ctx);
+      pthread_mutex_lock(&P->mtx);
+      if (--P->pending==0) pthread_cond_broadcast(&P->cond);
+      else if (P->pausefunc!=NULL && !P->pause && now()>=P->next)
+        poolpause(P);
+      pthread_mutex_unlock(&P->mtx);
+      continue;
+    }
+
+    /* nothing to steal: wait for new tasks or for the last ones to finish */
+    pthread_mutex_lock(&P->mtx);
+    while (P->pending>0 && P->gen==gen && !P->pause)
+      pthread_cond_wait(&P->cond,&P->mtx);
+    if (P->pending==0) {
+      P->live--;
+      pthread_cond_broadcast(&P->cond);
+      pthread_mutex_unlock(&P->mtx);
+      break;
+    }
+    pthread_mutex_unlock(&P->mtx);
+  }
+  return NULL;
+}
+# endif
+
+/** @endcond */
+
+/**
+ * @brief Create a work-stealing pool.
+ *
+ * @param[in] nworkers number of worker threads
+ * @param[in] func method called for every task
+ * @param[in] ctx user data passed to func
+ *
+ * @retval pool Return the pool (free with Poolfree).
+ */
+pool_t *Poolinit(unsigned nworkers, task_func_t func, void *ctx)
+{
+  pool_t *P=(pool_t*)malloc(sizeof(pool_t));
+  P->nworkers=nworkers==0 ? 1 : nworkers;
+  P->func=func;
+  P->ctx=ctx;
+  P->deques=(deque_t*)calloc(P->nworkers,sizeof(deque_t));
+  P->pausefunc=NULL;
+  P->interval=P->next=0;
+# if HAVE_PTHREAD
+  for (unsigned i=0; i<P->nworkers; i++)
+    pthread_mutex_init(&P->deques[i].mtx,NULL);
+  P->pending=0;
+  P->gen=0;
+  P->live=P->parked=0;
+  P->pause=false;
+  pthread_mutex_init(&P->mtx,NULL);
+  pthread_cond_init(&P->cond,NULL);
+# endif
+  return P;
+}
+
+/**
+ * @brief Queue a task on a worker.
+ *
+ * May be called before Poolrun or by a worker while the pool runs.
+ *
+ * @param[in,out] P pool
+ * @param[in] w index of the worker whose queue receives the task
+ * @param[in] task task handed to the task method
+ */
+void Poolpush(pool_t *P, unsigned w, void *task)
+{
+# if HAVE_PTHREAD
+  pthread_mutex_lock(&P->mtx);
+  P->pending++;
+  pthread_mutex_unlock(&P->mtx);
+# endif
+  dequepush(&P->deques[w%P->nworkers],task);
+# if HAVE_PTHREAD
+  pthread_mutex_lock(&P->mtx);
+  P->gen++;
+  pthread_cond_broadcast(&P->cond);
+  pthread_mutex_unlock(&P->mtx);
+# endif
+}
+
+/**
+ * @brief Run a method periodically while the pool runs.
+ *
+ * Every <b><tt>seconds</tt></b>, once a worker completes a task, the other
+ * workers are paused as they complete theirs, and the method is called with
+ * the user data of the pool while no task is running. Must be called before
+ * Poolrun.
+ *
+ * @param[in,out] P pool
+ * @param[in] seconds period
+ * @param[in] func method
+ */
+void Poolperiodic(pool_t *P, double seconds, pause_func_t func)
+{
+  P->pausefunc=func;
+  P->interval=seconds;
+}
+
+/**
+ * @brief Run the pool until every queued task has been completed.
+ *
+ * @param[in,out] P pool
+ */
+void Poolrun(pool_t *P)
+{
+# if HAVE_PTHREAD
+  int throw;
+  unsigned i;
+  pthread_t threads[P->nworkers];
+  worker_t workers[P->nworkers];
+
+  P->next=now()+P->interval;
+  P->live=P->nworkers;
+  for (i=0; i<P->nworkers; i++) {
+    workers[i].P=P;
+    workers[i].w=i;
+    if ( (throw=pthread_create(&threads[i],NULL,poolworker,&workers[i])) != 0)
+      error(1, throw, "pthread_create failed");
+  }
+  for (i=0; i<P->nworkers; i++)
+    if ( (throw=pthread_join(threads[i],NULL)) != 0)
+      error(1, throw, "pthread_join failed");
+# else
+  void *task;
+  P->next=now()+P->interval;
+  while (poolget(P,0,&task)) {
+    P->func(task,0,P->ctx);
+    if (P->pausefunc!=NULL && now()>=P->next) {
+      P->pausefunc(P->ctx);
+      P->next=now()+P->interval;
+    }
+  }
+# endif
+}
+
+/**
+ * @brief Free a pool.
+ *
+ * @param[in,out] P pool
+ */
+void Poolfree(pool_t *P)
+{
+  for (unsigned i=0; i<P->nworkers; i++) {
+    if (P->deques[i].tasks!=NULL) free(P->deques[i].tasks);
+# if HAVE_PTHREAD
+    pthread_mutex_destroy(&P->deques[i].mtx);
+# endif
+  }
+  free(P->deques);
+# if HAVE_PTHREAD
+  pthread_mutex_destroy(&P->mtx);
+  pthread_cond_destroy(&P->cond);
+# endif
+  free(P);
+}
@@ -0,0 +1,24 @@
+/**
+ * @file pool.h
+ * @brief Work-stealing thread pool declarations.
+ * @author Thomas Pender
+ */
+# ifndef POOL_H
+# define POOL_H
+
+/** @brief Task method: called with the task, the worker index and user data. */
+typedef void (*task_func_t)(void*, unsigned, void*);
+
+/** @brief Method run while every worker is paused (called with user data). */
+typedef void (*pause_func_t)(void*);
+
+/** @brief Work-stealing pool (see pool.c). */
+typedef struct pool pool_t;
+
+pool_t *Poolinit(unsigned, task_func_t, void*);
+void Poolpush(pool_t*, unsigned, void*);
+void Poolperiodic(pool_t*, double, pause_func_t);
+void Poolrun(pool_t*);
+void Poolfree(pool_t*);
+
+# endif
@@ -0,0 +1,413 @@
+/**
+ * @file records.c
+ * @brief Reader of the A/B output files.
+ *
+ * Reads the text lines printed by the searches as well as binary records (see
+ * BINRECORD), telling the two apart by the magic of the binary header. Every
+ * record is returned as the string in text form and its correlations, n/2 of
+ * them, or n-1 for unrestricted strings (see argcomplex): the kind of the
+ * header tells, or else the number on the first line. Binary
+ * files may be concatenations (e.g. of shards): repeated headers are skipped,
+ * as no record starts with the first byte of the magic.
+ *
+ * Regular files are mapped into memory and parsed in place, with no copy of
+ * the records and no allocation per record. A record can be referred to by
+ * its offset in the mapping (see Readerscan), and its string decoded from the
+ * mapping only when needed (see Readerseq). The pages read are released every
+ * DROP bytes, so the resident set of a reader stays small however large the
+ * file; the pages of records referred to later are read again from the file.
+ * Pipes and stdin are read through stdio instead. A mapped file may also be
+ * split into parts on record boundaries, read concurrently by readers of
+ * their own (see Readerparts).
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <string.h>
+# include <unistd.h>
+# include <fcntl.h>
+# include <error.h>
+# include <errno.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+/* project headers */
+# include <records.h>
+# include <output.h>
+
+# define DROP ((size_t)4<<20U) ///< bytes of a mapping read before release
+
+/** @cond */
+
+struct reader {
+  FILE *fp;
+  const char *file;
+  unsigned n;
+  unsigned m;                /* number of correlations */
+  bool binary;
+  const unsigned char *map;  /* mapping of the file, or NULL if read by stdio */
+  size_t size, pos;          /* size of the mapping, offset of next record */
+  size_t dropped;            /* offset up to which the mapping was released */
+  const char *s, *e;         /* current text line */
+  unsigned char *rec;        /* binary record (stdio) */
+  char *line;                /* text line (stdio; pending if pending is set) */
+  size_t cap;
+  bool pending;
+  bool part;                 /* whether the mapping belongs to another reader */
+};
+
+/* next line into R->s, R->e (without the newline) */
+static
+bool textline(reader_t *R)
+{
+  if (R->map!=NULL) {
+    const char *s=(const char*)R->map+R->pos, *e;
+    if (R->pos>=R->size) return false;
+    if ( (e=(const char*)memchr(s,'\n',R->size-R->pos))==NULL )
+      e=(const char*)R->map+R->size;
+    R->s=s;
+    R->e=e;
+    R->pos=(size_t)(e-(const char*)R->map)+1;
+    return true;
+  }
+
+  ssize_t len=getline(&R->line,&R->cap,R->fp);
+  if (len<0) return false;
+  if (len>0 && R->line[len-1]=='\n') len--;
+  R->s=R->line;
+  R->e=R->line+len;
+  return true;
+}
+
+static
+void malformed(const reader_t *R, const char *what)
+{
+  error(1, 0, "%s -- malformed %s: %.*s", R->file, what, (int)(R->e-R->s),
+        R->s);
+}
+
+/* correlations of the current line, parsed in place */
+static
+void textparse(const reader_t *R, signed char *corrs)
+{
+  const char *s=R->s+R->n+1, *e=R->e;
+  size_t i, l=R->m;
+  unsigned v, d;
+  bool neg;
+
+  if ((size_t)(e-R->s)<=R->n || R->s[R->n]!=' ') malformed(R,"line");
+  for (i=0; i<l; i++) {
+    if ( (neg= s<e && *s=='-') ) s++;
+    for (v=0, d=0; s<e && *s>='0' && *s<='9' && v<=128; s++, d++)
+      v=10*v+(unsigned)(*s-'0');
+    if (d==0 || v>(neg ? 128U : 127U)
+        || (i+1<l ? s==e || *s!=',' : s!=e))
+      malformed(R,"correlations");
+    corrs[i]=(signed char)(neg ? -(int)v : (int)v);
+    s++;
+  }
+}
+
+/* release the pages of the mapping read so far, once DROP bytes or all of
+   them (at the end of the file or part) */
+static inline
+void drop(reader_t *R, bool all)
+{
+  size_t page, end=R->pos<R->size ? R->pos : R->size;
+  if (end-R->dropped<(all ? 1 : DROP)) return;
+  page=(size_t)sysconf(_SC_PAGESIZE);
+  end=end/page*page;
+  if (end<=R->dropped) return;
+  madvise((void*)(R->map+R->dropped),end-R->dropped,MADV_DONTNEED);
+  R->dropped=end;
+}
+
+/* map a regular file, NULL if it cannot be */
+static
+const unsigned char *filemap(const char *file, size_t *size)
+{
+  struct stat st;
+  void *map=MAP_FAILED;
+  int fd;
+
+  if ( (fd=open(file,O_RDONLY))<0 ) error(1, errno, "failed to open %s", file);
+  if (fstat(fd,&st)==0 && S_ISREG(st.st_mode) && st.st_size>0) {
+    *size=(size_t)st.st_size;
+    map=mmap(NULL,*size,PROT_READ,MAP_PRIVATE,fd,0);
+  }
+  close(fd);
+  if (map==MAP_FAILED) return NULL;
+  madvise(map,*size,MADV_SEQUENTIAL);
+  return (const unsigned char*)map;
+}
+
+/** @endcond */
+
+/**
+ * @brief Open an output file of the searches.
+ *
+ * @param[in] file text or binary output file ("-" for stdin)
+ *
+ * @retval reader Return the reader (free with Readerclose).
+ */
+reader_t *Readeropen(const char *file)
+{
+  reader_t *R=(reader_t*)calloc(1,sizeof(reader_t));
+  const char *p;
+  char kind;
+  int c;
+  size_t i;
+
+  R->file=file;
+  if (strcmp(file,"-")==0) R->fp=stdin;
+  else if ( (R->map=filemap(file,&R->size))==NULL
+            && (R->fp=fopen(file,"rb"))==NULL )
+    error(1, errno, "failed to open %s", file);
+
+  /* binary files start with the magic, text files with a digit */
+  if (R->map!=NULL) c=R->map[0];
+  else if ( (c=getc(R->fp))==EOF ) return R;
+  else ungetc(c,R->fp);
+  if (c==BINMAGIC[0]) {
+    if (R->map!=NULL
+        ? R->size<BINHEADER || !Binheaderparse(R->map,&kind,&R->n)
+        : !Binheaderread(R->fp,&kind,&R->n))
+      error(1, 0, "%s -- malformed binary header", file);
+    R->binary=true;
+    R->m=BINCORRS(kind,R->n);
+    R->pos=BINHEADER;
+    if (R->map==NULL) R->rec=(unsigned char*)malloc(BINRECORD(R->n,R->m));
+    return R;
+  }
+
+  if (!textline(R)) return R;
+  for (p=R->s; p<R->e && *p>='0' && *p<='3'; p++);
+  i=(size_t)(p-R->s);
+  if (p==R->e || *p!=' ' || i==0 || i&1U || i>BINMAXN) malformed(R,"line");
+  R->n=(unsigned)i;
+  for (R->m=1; p<R->e; p++) R->m+=*p==',';
+  if (R->m!=R->n/2 && R->m!=R->n-1) malformed(R,"correlations");
+  R->pending=true;
+  return R;
+}
+
+/**
+ * @brief String length of the records (0 for an empty file).
+ * @param[in] R reader
+ * @retval n Return the string length.
+ */
+unsigned Readerlength(const reader_t *R)
+{
+  return R->n;
+}
+
+/**
+ * @brief Number of correlations of the records (n/2, or n-1 for unrestricted
+ * strings).
+ * @param[in] R reader
+ * @retval m Return the number of correlations.
+ */
+unsigned Readercorrs(const reader_t *R)
+{
+  return R->m;
+}
+
+/**
+ * @brief Whether the file is mapped, i.e. whether the references of its
+ * records stay valid (see Readerscan).
+ * @param[in] R reader
+ * @retval mapped Return whether the file is mapped.
+ */
+bool Readermapped(const reader_t *R)
+{
+  return R->map!=NULL;
+}
+
+/**
+ * @brief Split a mapped file into parts read concurrently.
+ *
+ * The parts hold about the same number of bytes each, and all the records of
+ * the file between them, in order. The references of the records of every
+ * part are those of the file (see Readerscan), so that any of the readers can
+ * decode them.
+ *
+ * @param[in] R reader of a mapped file (see Readermapped), none of whose
+ * records was read yet
+ * @param[in] m number of parts
+ *
+ * @retval parts Return the readers of the m parts (close each with
+ * Readerclose, and free the array, before closing R).
+ */
+reader_t **Readerparts(const reader_t *R, unsigned m)
+{
+  reader_t **parts=(reader_t**)malloc(m*sizeof(reader_t*));
+  size_t lo[m+1], len=BINRECORD(R->n,R->m), page=(size_t)sysconf(_SC_PAGESIZE);
+  size_t pos, end, dropped=0;
+  const char *e;
+  unsigned i;
+
+  if (parts==NULL) error(1, errno, "malloc failed");
+  lo[0]=R->binary ? BINHEADER : 0;
+  lo[m]=R->n==0 ? lo[0] : R->size;
+  if (R->n==0) for (i=1; i<m; i++) lo[i]=lo[0];
+  else if (R->binary) {
+    /* headers of concatenated files shift the records: walk the file */
+    for (pos=lo[0], i=1; i<m; ) {
+      if (pos>=R->size) lo[i++]=R->size;
+      else if (pos>=(size_t)i*(R->size/m)) lo[i++]=pos;
+      else pos+=R->map[pos]==BINMAGIC[0] ? BINHEADER : len;
+      end=(pos<R->size ? pos : R->size)/page*page;
+      if ((i==m || end-dropped>=DROP) && end>dropped) {
+        madvise((void*)(R->map+dropped),end-dropped,MADV_DONTNEED);
+        dropped=end;
+      }
+    }
+  }
+  else
+    for (i=1; i<m; i++) {
+      pos=(size_t)i*(R->size/m);
+      if (pos<=lo[i-1]) pos=lo[i-1];
+      else if (R->map[pos-1]!='\n')
+        pos= (e=(const char*)memchr(R->map+pos,'\n',R->size-pos))==NULL
+          ? R->size : (size_t)(e-(const char*)R->map)+1;
+      lo[i]=pos;
+    }
+
+  for (i=0; i<m; i++) {
+    if ( (parts[i]=(reader_t*)malloc(sizeof(reader_t)))==NULL )
+      error(1, errno, "malloc failed");
+    *parts[i]=*R;
+    parts[i]->pos=lo[i];
+    parts[i]->size=lo[i+1];
+    parts[i]->dropped=lo[i]/page*page;
+    parts[i]->pending=false;
+    parts[i]->part=true;
+  }
+  return parts;
+}
+
+/**
+ * @brief Read the correlations of the next record, without its string.
+ *
+ * @param[in,out] R reader
+ * @param[out] corrs the correlations (see Readercorrs)
+ *
+ * @retval ref Return a reference to the record for Readerseq (its offset in
+ * the mapping plus one), or 0 if there is none left. The references of a
+ * reader that is not mapped (see Readermapped) designate the last record read
+ * only.
+ */
+size_t Readerscan(reader_t *R, signed char *corrs)
+{
+  size_t len=BINRECORD(R->n,R->m), ref;
+  unsigned n;
+  char kind;
+  int c;
+
+  if (R->n==0) return 0;
+  if (R->binary && R->map!=NULL) {
+    drop(R,false);
+    /* header of a concatenated file */
+    while (R->pos<R->size && R->map[R->pos]==BINMAGIC[0]) {
+      if (R->size-R->pos<BINHEADER || !Binheaderparse(R->map+R->pos,&kind,&n)
+          || n!=R->n || BINCORRS(kind,n)!=R->m)
+        error(1, 0, "%s -- malformed binary header", R->file);
+      R->pos+=BINHEADER;
+    }
+    if (R->size-R->pos<len) {
+      drop(R,true);
+      return 0;
+    }
+    ref=R->pos+1;
+    R->pos+=len;
+    memcpy(corrs,R->map+ref-1+1+(R->n+3)/4,R->m);
+    return ref;
+  }
+  if (R->binary) {
+    while ( (c=getc(R->fp))==BINMAGIC[0] ) { /* header of a concatenated file */
+      ungetc(c,R->fp);
+      if (!Binheaderread(R->fp,&kind,&n) || n!=R->n || BINCORRS(kind,n)!=R->m)
+        error(1, 0, "%s -- malformed binary header", R->file);
+    }
+    if (c==EOF) return 0;
+    ungetc(c,R->fp);
+    if (fread(R->rec,1,len,R->fp)!=len) {
+      if (ferror(R->fp)) error(1, errno, "%s -- fread failed", R->file);
+      return 0;
+    }
+    memcpy(corrs,R->rec+1+(R->n+3)/4,R->m);
+    return 1;
+  }
+
+  if (R->map!=NULL) drop(R,false);
+  if (R->pending) R->pending=false;
+  else {
+    do
+      if (!textline(R)) {
+        if (R->map!=NULL) drop(R,true);
+        return 0;
+      }
+    while (R->s==R->e); /* skip blank lines */
+  }
+  textparse(R,corrs);
+  return R->map!=NULL ? (size_t)((const unsigned char*)R->s-R->map)+1 : 1;
+}
+
+/**
+ * @brief String of a record.
+ *
+ * @param[in] R reader
+ * @param[in] ref reference to the record (see Readerscan)
+ * @param[out] seq string as text (n characters and a terminating zero)
+ */
+void Readerseq(const reader_t *R, size_t ref, char *seq)
+{
+  const unsigned char *p=R->map!=NULL ? R->map+ref-1
+    : R->binary ? R->rec : (const unsigned char*)R->s;
+  size_t i;
+
+  if (R->binary)
+    for (i=0; i<R->n; i++)
+      seq[i]=(char)('0'+((p[1+(i>>2U)]>>(2*(i&3U)))&3U));
+  else memcpy(seq,p,R->n);
+  seq[R->n]='\0';
+}
+
+/**
+ * @brief Read the next record.
+ *
+ * @param[in,out] R reader
+ * @param[out] seq string as text (n characters and a terminating zero)
+ * @param[out] corrs the correlations (see Readercorrs)
+ *
+ * @retval read Return whether a record was read.
+ */
+bool Readernext(reader_t *R, char *seq, signed char *corrs)
+{
+  size_t ref=Readerscan(R,corrs);
+  if (ref==0) return false;
+  Readerseq(R,ref,seq);
+  return true;
+}
+
+/**
+ * @brief Close a reader.
+ * @param[in,out] R reader
+ */
+void Readerclose(reader_t *R)
+{
+  if (R->part) {
+    free(R);
+    return;
+  }
+  if (R->map!=NULL) munmap((void*)R->map,R->size);
+  else if (R->fp!=stdin) fclose(R->fp);
+  if (R->rec!=NULL) free(R->rec);
+  if (R->line!=NULL) free(R->line);
+  free(R);
+}
@@ -0,0 +1,26 @@
+/**
+ * @file records.h
+ * @brief Reader of the A/B output files declarations.
+ * @author Thomas Pender
+ */
+# ifndef RECORDS_H
+# define RECORDS_H
+
+/* std headers */
+# include <stddef.h>
+# include <stdbool.h>
+
+/** @brief Reader of text or binary output files (see records.c). */
+typedef struct reader reader_t;
+
+reader_t *Readeropen(const char*);
+unsigned Readerlength(const reader_t*);
+unsigned Readercorrs(const reader_t*);
+bool Readermapped(const reader_t*);
+reader_t **Readerparts(const reader_t*, unsigned);
+size_t Readerscan(reader_t*, signed char*);
+void Readerseq(const reader_t*, size_t, char*);
+bool Readernext(reader_t*, char*, signed char*);
+void Readerclose(reader_t*);
+
+# endif
@@ -0,0 +1,734 @@
+/**
+ * @file search.c
+ * @brief Parallel fixed content bracelet search.
+ *
+ * The recursion trees of all content classes are cut at a fixed prefix length.
+ * Every node at that depth becomes a task for a work-stealing pool (see pool.c),
+ * so that the workers stay busy however unevenly the work is spread over the
+ * content classes.
+ *
+ * The tasks are the same for the same string length and prefix length, so a
+ * search can be checkpointed by the set of completed tasks. Periodically the
+ * workers are paused between tasks (see Poolperiodic), the output written so
+ * far is flushed, and the completed tasks and the output offset are saved. A
+ * resumed search truncates the output to that offset and runs only the tasks
+ * not yet completed, so no output is lost or duplicated.
+ *
+ * For the same reason a search can be split into shards run on separate
+ * machines: the tasks are dealt to the shards by their estimated cost (the
+ * number of arrangements of the content left to place), largest first onto
+ * the least loaded shard, and every shard runs its own tasks only.
+ *
+ * Every worker counts what it does in counters of its own (see stats_t), so
+ * that nothing is shared on the hot path. A reporter sums them up
+ * periodically and reports the rates and the fraction done by estimated cost,
+ * from which the time left is extrapolated; a summary is written at the end.
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdbool.h>
+# include <string.h>
+# include <time.h>
+# include <unistd.h>
+# include <libgen.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <defs.h>
+# include <bracelets.h>
+# include <seq_funcs.h>
+# include <search.h>
+# include <pool.h>
+# include <output.h>
+
+# if HAVE_PTHREAD
+# include <pthread.h>
+# endif
+
+# define JOBS_PER_THREAD 32 ///< number of tasks aimed for per worker thread
+# define CKPT_JOBS 4096     ///< number of tasks aimed for when checkpointing
+# define CKPT_SECONDS 600   ///< default time between checkpoints
+# define CKPT_MAGIC "LPQC"  ///< magic of checkpoint files
+# define SHARD_JOBS 256     ///< number of tasks aimed for per shard
+
+/** @cond */
+
+typedef struct {
+  size_t id;
+  unsigned cls;
+  double cost; /* estimated cost (see Nodearrangements) */
+  node_t *node;
+} job_t;
+
+typedef struct {
+  unsigned cls;
+  const neck_t *neck;
+  job_t **jobs;
+  size_t njobs, cap;
+} collect_t;
+
+typedef struct {
+  bool init;
+  neck_t neck;
+  args_t args;
+} slot_t;
+
+typedef struct {
+  search_t *S;
+  slot_t *slots;
+  writer_t *W;
+  join_t **joins; /* indexes of the workers (Searchindex), or NULL */
+  FILE *fp;       /* output stream */
+  char *ckpt;     /* checkpoint file, or NULL */
+  char *done;     /* whether each task is completed (checkpoints only) */
+  size_t njobs;
+  stats_t *stats; /* counters of the workers */
+  double total;   /* estimated cost of the tasks run */
+  double start;   /* start time */
+  double next;    /* time of the next report (no pthreads) */
+  FILE *statsfp;  /* stream of the reports, or NULL */
+# if HAVE_PTHREAD
+  pthread_mutex_t mtx;
+  pthread_mutex_t rmtx; /* reporter */
+  pthread_cond_t rcond;
+  bool stop;
+# endif
+} ctx_t;
+
+static inline
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+1e-9*(double)ts.tv_nsec;
+}
+
+/* sum of the counters of the workers (read while they run) */
+static
+void statsum(const ctx_t *C, stats_t *T)
+{
+  double done;
+  *T=(stats_t){0};
+  for (unsigned w=0; w<C->S->nthreads; w++) {
+    const stats_t *s=&C->stats[w];
+    T->nodes+=__atomic_load_n(&s->nodes,__ATOMIC_RELAXED);
+    T->strings+=__atomic_load_n(&s->strings,__ATOMIC_RELAXED);
+    T->realrejects+=__atomic_load_n(&s->realrejects,__ATOMIC_RELAXED);
+    T->psdtestrejects+=__atomic_load_n(&s->psdtestrejects,__ATOMIC_RELAXED);
+    T->filterrejects+=__atomic_load_n(&s->filterrejects,__ATOMIC_RELAXED);
+    T->symrejects+=__atomic_load_n(&s->symrejects,__ATOMIC_RELAXED);
+    T->emitted+=__atomic_load_n(&s->emitted,__ATOMIC_RELAXED);
+    __atomic_load(&s->done,&done,__ATOMIC_RELAXED);
+    T->done+=done;
+  }
+}
+
+static
+void report(ctx_t *C)
+{
+  stats_t T;
+  double t=now()-C->start, f;
+
+  statsum(C,&T);
+  f=C->total>0 ? T.done/C->total : 1;
+  if (t<=0) t=1e-9;
+  fprintf(C->statsfp,"# %c %u: %.1f s, %.2f%% done, %lu nodes (%.4g/s), "
+          "%lu strings (%.4g/s), %lu emitted (%.4g/s), eta ",C->S->kind,
+          C->S->n,t,100*f,T.nodes,T.nodes/t,T.strings,T.strings/t,T.emitted,
+          T.emitted/t);
+  if (f>0) fprintf(C->statsfp,"%.1f s\n",t*(1-f)/f);
+  else fprintf(C->statsfp,"unknown\n");
+  fflush(C->statsfp);
+}
+
+/* one line of JSON, for capacity planning */
+static
+void summary(ctx_t *C)
+{
+  search_t *S=C->S;
+  stats_t T;
+  unsigned w;
+
+  statsum(C,&T);
+  fprintf(C->statsfp,"{\"kind\":\"%c\",\"n\":%u,\"depth\":%u,"
+          "\"workers\":%u,\"seconds\":%.3f,\"nodes\":%lu,\"strings\":%lu,"
+          "\"rejects\":{\"realcorrs\":%lu,\"psdtest\":%lu,\"filtertest\":%lu,"
+          "\"symtest\":%lu},\"emitted\":%lu",S->kind,S->n,S->depth,
+          S->nthreads,now()-C->start,T.nodes,T.strings,T.realrejects,
+          T.psdtestrejects,T.filterrejects,T.symrejects,T.emitted);
+  fprintf(C->statsfp,",\"per_worker\":[");
+  for (w=0; w<S->nthreads; w++)
+    fprintf(C->statsfp,"%s{\"nodes\":%lu,\"strings\":%lu,\"emitted\":%lu}",
+            w>0 ? "," : "",C->stats[w].nodes,C->stats[w].strings,
+            C->stats[w].emitted);
+  fprintf(C->statsfp,"]}\n");
+  fflush(C->statsfp);
+}
+
+# if HAVE_PTHREAD
+static
+void *reporter(void *_ctx)
+{
+  ctx_t *C=(ctx_t*)_ctx;
+  double next=C->start+C->S->progress;
+  struct timespec ts;
+
+  pthread_mutex_lock(&C->rmtx);
+  while (!C->stop) {
+    ts.tv_sec=(time_t)next;
+    ts.tv_nsec=(long)(1e9*(next-(double)ts.tv_sec));
+    /* the clock of the condition variable is set to CLOCK_MONOTONIC */
+    if (pthread_cond_timedwait(&C->rcond,&C->rmtx,&ts)==0 || C->stop)
+      continue;
+    if (now()>=next) {
+      report(C);
+      while (next<=now()) next+=C->S->progress;
+    }
+  }
+  pthread_mutex_unlock(&C->rmtx);
+  return NULL;
+}
+# endif
+
+static
+void countnode(const node_t *node, void *_count)
+{
+  (void)node;
+  (*(size_t*)_count)++;
+}
+
+static
+int costcmp(const void *_a, const void *_b)
+{
+  const job_t *a=*(job_t*const*)_a, *b=*(job_t*const*)_b;
+  if (a->cost!=b->cost) return a->cost>b->cost ? -1 : 1;
+  return a->id<b->id ? -1 : a->id>b->id;
+}
+
+static
+void collectnode(const node_t *node, void *_C)
+{
+  collect_t *C=(collect_t*)_C;
+  if (C->njobs==C->cap) {
+    C->cap=C->cap==0 ? 256 : 2*C->cap;
+    C->jobs=(job_t**)realloc(C->jobs,C->cap*sizeof(job_t*));
+    if (C->jobs==NULL) error(1, errno, "realloc failed");
+  }
+  job_t *J=(job_t*)malloc(sizeof(job_t));
+  J->id=C->njobs;
+  J->cls=C->cls;
+  J->cost=Nodearrangements(node,C->neck->k);
+  J->node=Nodecopy(node,C->neck);
+  C->jobs[C->njobs++]=J;
+}
+
+/* walk the recursion trees of all content classes down to depth */
+static
+void splitclasses(search_t *S, unsigned depth, split_t split, void *_arg,
+                  collect_t *C)
+{
+  neck_t neck;
+  args_t args;
+  for (unsigned i=0; i<S->nclasses; i++) {
+    S->classinit(S->n,i,&neck,&args);
+    neck.depth=depth;
+    neck.split=split;
+    neck.splitarg=_arg;
+    if (C!=NULL) {
+      C->cls=i;
+      C->neck=&neck;
+    }
+    if (neck.necklaces)
+      FCNecklace(&neck,&args
+# if HAVE_PTHREAD
+                 ,NULL
+# endif
+                 );
+    else
+      FCBracelet(&neck,&args
+# if HAVE_PTHREAD
+                 ,NULL
+# endif
+                 );
+    Argfree(&args);
+    Neckfree(&neck);
+  }
+}
+
+/* smallest prefix length giving enough tasks to keep the workers busy */
+static
+unsigned splitdepth(search_t *S)
+{
+  size_t count=0, target=(size_t)JOBS_PER_THREAD*S->nthreads;
+  unsigned depth;
+
+  if (S->ckpt>0 && target<CKPT_JOBS) target=CKPT_JOBS; /* less work lost */
+  if (S->nshards>1) { /* the same on every machine */
+    target=(size_t)SHARD_JOBS*S->nshards;
+    if (target<CKPT_JOBS) target=CKPT_JOBS;
+  }
+  for (depth=1; depth+1<S->n; depth++) {
+    count=0;
+    splitclasses(S,depth,countnode,&count,NULL);
+    if (count>=target) break;
+  }
+  return depth;
+}
+
+static
+void runjob(void *_job, unsigned w, void *_ctx)
+{
+  job_t *J=(job_t*)_job;
+  ctx_t *C=(ctx_t*)_ctx;
+  slot_t *slot=&C->slots[(size_t)w*C->S->nclasses+J->cls];
+
+  if (!slot->init) {
+    C->S->classinit(C->S->n,J->cls,&slot->neck,&slot->args);
+    slot->args.out=Writerbuf(C->W,w);
+    slot->args.binary=C->S->binary;
+    slot->args.cls=J->cls;
+    slot->args.stats=&C->stats[w];
+    if (C->joins!=NULL) {
+      slot->neck.seqprint=indexseq;
+      slot->args.join=C->joins[w];
+    }
+    else if (C->S->join!=NULL) {
+      slot->neck.seqprint=pairseq;
+      slot->args.join=C->S->join;
+    }
+    if (C->S->filter!=NULL) { /* last, after the cheaper checks */
+      neck_t *N=&slot->neck;
+      N->checkfuncs=(check_t*)realloc(N->checkfuncs,
+                                      (N->ncheckfuncs+1)*sizeof(check_t));
+      if (N->checkfuncs==NULL) error(1, errno, "realloc failed");
+      N->checkfuncs[N->ncheckfuncs++]=filtertest;
+      slot->args.filter=C->S->filter;
+    }
+    if (C->S->reduce) /* only one side of a pair may be decimated */
+      Argsym(&slot->neck,&slot->args,C->S->kind=='A');
+    slot->init=true;
+  }
+  if (slot->neck.necklaces)
+    FCNecklacesub(&slot->neck,J->node,&slot->args
+# if HAVE_PTHREAD
+                  ,&C->mtx
+# endif
+                  );
+  else
+    FCBraceletsub(&slot->neck,J->node,&slot->args
+# if HAVE_PTHREAD
+                  ,&C->mtx
+# endif
+                  );
+  STATADD(slot->args.stats,nodes,slot->neck.nodes);
+  slot->neck.nodes=0;
+  if (C->done!=NULL) C->done[J->id]=1;
+  double done=C->stats[w].done+J->cost;
+  __atomic_store(&C->stats[w].done,&done,__ATOMIC_RELAXED);
+# if !HAVE_PTHREAD
+  if (C->S->progress>0 && now()>=C->next) {
+    report(C);
+    while (C->next<=now()) C->next+=C->S->progress;
+  }
+# endif
+
+  Nodefree(J->node);
+  free(J);
+}
+
+/* mark the tasks of shard S->shard: largest first onto the least loaded */
+static
+char *shardjobs(const search_t *S, const collect_t *C)
+{
+  job_t **order=(job_t**)malloc(C->njobs*sizeof(job_t*));
+  double load[S->nshards];
+  char *mine=(char*)calloc(C->njobs+1,1);
+  size_t i;
+  unsigned p, q;
+
+  for (i=0; i<C->njobs; i++) order[i]=C->jobs[i];
+  qsort(order,C->njobs,sizeof(job_t*),costcmp);
+  for (p=0; p<S->nshards; p++) load[p]=0;
+  for (i=0; i<C->njobs; i++) {
+    for (p=0, q=1; q<S->nshards; q++) if (load[q]<load[p]) p=q;
+    load[p]+=order[i]->cost;
+    mine[order[i]->id]=p+1==S->shard;
+  }
+  free(order);
+  return mine;
+}
+
+/* save the completed tasks and the output offset; no task is running */
+static
+void checkpoint(void *_ctx)
+{
+  ctx_t *C=(ctx_t*)_ctx;
+  search_t *S=C->S;
+  size_t len=strlen(C->ckpt);
+  char tmp[len+5];
+  off_t offset;
+  FILE *fp;
+
+  Writerflush(C->W);
+  if (fsync(fileno(C->fp))!=0) error(1, errno, "fsync failed");
+  if ( (offset=ftello(C->fp))<0 ) error(1, errno, "ftello failed");
+
+  /* written aside and renamed, so that a crash leaves the last one intact */
+  snprintf(tmp,sizeof(tmp),"%s.tmp",C->ckpt);
+  if ( (fp=fopen(tmp,"w"))==NULL ) error(1, errno, "failed to open %s", tmp);
+  fprintf(fp,"%s %c %u %u %d %u/%u %zu %lld\n",CKPT_MAGIC,S->kind,S->n,
+          S->depth,(int)S->binary|(int)S->reduce<<1,S->shard,S->nshards,
+          C->njobs,(long long)offset);
+  for (size_t i=0; i<C->njobs; i++) fputc('0'+C->done[i],fp);
+  fputc('\n',fp);
+  if (fflush(fp)!=0 || fsync(fileno(fp))!=0 || fclose(fp)!=0)
+    error(1, errno, "failed to write %s", tmp);
+  if (rename(tmp,C->ckpt)!=0) error(1, errno, "failed to rename %s", tmp);
+}
+
+/* read a checkpoint; sets the prefix length, returns the output offset */
+static
+off_t ckptread(ctx_t *C)
+{
+  search_t *S=C->S;
+  char magic[5], kind;
+  unsigned n, depth, shard, nshards;
+  int flags, c;
+  long long offset;
+  size_t i;
+  FILE *fp;
+
+  if ( (fp=fopen(C->ckpt,"r"))==NULL )
+    error(1, errno, "failed to open %s", C->ckpt);
+  if (fscanf(fp,"%4s %c %u %u %d %u/%u %zu %lld ",magic,&kind,&n,&depth,
+             &flags,&shard,&nshards,&C->njobs,&offset)!=9
+      || strcmp(magic,CKPT_MAGIC)!=0)
+    error(1, 0, "%s -- not a checkpoint file", C->ckpt);
+  if (kind!=S->kind || n!=S->n || (bool)(flags&1)!=S->binary
+      || (bool)(flags&2)!=S->reduce
+      || shard!=S->shard || nshards!=S->nshards)
+    error(1, 0, "%s -- checkpoint of another search", C->ckpt);
+  C->done=(char*)malloc(C->njobs+1);
+  for (i=0; i<C->njobs; i++) {
+    if ( (c=fgetc(fp))!='0' && c!='1' )
+      error(1, 0, "%s -- truncated checkpoint file", C->ckpt);
+    C->done[i]=(char)(c-'0');
+  }
+  fclose(fp);
+  S->depth=depth;
+  return (off_t)offset;
+}
+
+static
+void runsearch(search_t *S, ctx_t *ctx)
+{
+  size_t i;
+  collect_t C={.jobs=NULL,.njobs=0,.cap=0};
+  char *mine=NULL;
+
+  if (S->depth==0) S->depth=splitdepth(S);
+  splitclasses(S,S->depth,collectnode,&C,&C);
+  if (ctx->ckpt!=NULL) {
+    if (ctx->done==NULL) {
+      ctx->njobs=C.njobs;
+      ctx->done=(char*)calloc(C.njobs+1,1);
+    }
+    else if (ctx->njobs!=C.njobs)
+      error(1, 0, "%s -- checkpoint of another search", ctx->ckpt);
+  }
+  if (S->nshards>1 && ctx->joins==NULL) mine=shardjobs(S,&C);
+
+  ctx->slots=(slot_t*)calloc((size_t)S->nthreads*S->nclasses,sizeof(slot_t));
+  ctx->stats=(stats_t*)aligned_alloc(_Alignof(stats_t),
+                                     S->nthreads*sizeof(stats_t));
+  if (ctx->stats==NULL) error(1, errno, "aligned_alloc failed");
+  for (i=0; i<S->nthreads; i++) ctx->stats[i]=(stats_t){0};
+  ctx->statsfp=NULL;
+  if (S->statsfile!=NULL) {
+    if ( (ctx->statsfp=fopen(S->statsfile,"a"))==NULL )
+      error(1, errno, "failed to open %s", S->statsfile);
+  }
+  else if (S->progress>0) ctx->statsfp=stderr;
+  ctx->total=0;
+# if HAVE_PTHREAD
+  pthread_mutex_init(&ctx->mtx,NULL);
+# endif
+
+  ctx->W=Writerinit(ctx->fp,S->nthreads);
+  pool_t *P=Poolinit(S->nthreads,runjob,ctx);
+  if (ctx->ckpt!=NULL) Poolperiodic(P,S->ckpt,checkpoint);
+  for (i=0; i<C.njobs; i++) {
+    if ((ctx->done!=NULL && ctx->done[i]) /* completed before the resume */
+        || (mine!=NULL && !mine[i])) {     /* task of another shard */
+      Nodefree(C.jobs[i]->node);
+      free(C.jobs[i]);
+    }
+    else {
+      ctx->total+=C.jobs[i]->cost;
+      Poolpush(P,(unsigned)(i%S->nthreads),C.jobs[i]);
+    }
+  }
+  ctx->start=now();
+  ctx->next=ctx->start+S->progress;
+# if HAVE_PTHREAD
+  pthread_t rep;
+  if (S->progress>0) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+    pthread_cond_init(&ctx->rcond,&attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&ctx->rmtx,NULL);
+    ctx->stop=false;
+    if (pthread_create(&rep,NULL,reporter,ctx)!=0)
+      error(1, errno, "pthread_create failed");
+  }
+# endif
+  Poolrun(P);
+# if HAVE_PTHREAD
+  if (S->progress>0) {
+    pthread_mutex_lock(&ctx->rmtx);
+    ctx->stop=true;
+    pthread_cond_signal(&ctx->rcond);
+    pthread_mutex_unlock(&ctx->rmtx);
+    pthread_join(rep,NULL);
+    pthread_cond_destroy(&ctx->rcond);
+    pthread_mutex_destroy(&ctx->rmtx);
+  }
+# endif
+  Poolfree(P);
+  Writerfree(ctx->W);
+  if (ctx->statsfp!=NULL) {
+    summary(ctx);
+    if (ctx->statsfp!=stderr && fclose(ctx->statsfp)!=0)
+      error(1, errno, "failed to close %s", S->statsfile);
+  }
+
+  for (i=0; i<(size_t)S->nthreads*S->nclasses; i++)
+    if (ctx->slots[i].init) {
+      Argfree(&ctx->slots[i].args);
+      Neckfree(&ctx->slots[i].neck);
+    }
+  free(ctx->slots);
+  free(ctx->stats);
+  free(C.jobs);
+  if (mine!=NULL) free(mine);
+# if HAVE_PTHREAD
+  pthread_mutex_destroy(&ctx->mtx);
+# endif
+}
+
+/** @endcond */
+
+/**
+ * @brief Parse the command line of a search executable.
+ *
+ * Usage: <b><tt>[-b] [-u] [-f filter] [-o out_file [-c seconds] [-r]] [-s i/m]
+ * [-e probes] [-p seconds] [-t stats_file] [-j threads] [-d depth]
+ * <length></tt></b>, preceded by <b><tt>[-k A|B]</tt></b> for unrestricted
+ * searches (<b><tt>S->kind</tt></b> 'a' or 'b', set to 'a' or 'b' by the
+ * side). Exits with a usage message on malformed input.
+ * With <b><tt>-u</tt></b>, the strings are reduced by the symmetries of their
+ * classes (see Argsym). The filter file (see bloom.c) is read into
+ * <b><tt>S->filter</tt></b>. With <b><tt>-c</tt></b>, a checkpoint is saved to
+ * <b><tt>out_file.ckpt</tt></b> that often; <b><tt>-r</tt></b> resumes from it
+ * (and keeps checkpointing). With <b><tt>-e probes</tt></b>, the search is
+ * to be estimated instead of run (see Estimate). With
+ * <b><tt>-s i/m</tt></b>, only the i-th of m shards of the search is run
+ * (1 <= i <= m); the outputs of all m shards together are the output of the
+ * whole search. With <b><tt>-p</tt></b>,
+ * progress is reported that often; the reports and the summary go to stderr,
+ * or are appended to <b><tt>stats_file</tt></b> with <b><tt>-t</tt></b>.
+ *
+ * @param[in] argc argument count
+ * @param[in] argv argument vector
+ * @param[out] S search parameters
+ */
+void Searchopts(int argc, char **argv, search_t *S)
+{
+  int opt;
+  long nprocs=sysconf(_SC_NPROCESSORS_ONLN);
+  const bool unrestricted=S->kind=='a' || S->kind=='b';
+  const char *side=unrestricted ? "[-k A|B] " : "";
+
+  S->nthreads=nprocs>0 ? (unsigned)nprocs : 1;
+  S->depth=0;
+  S->binary=false;
+  S->reduce=false;
+  S->filter=NULL;
+  S->outfile=NULL;
+  S->ckpt=0;
+  S->resume=false;
+  S->shard=S->nshards=1;
+  S->probes=0;
+  S->progress=0;
+  S->statsfile=NULL;
+  while ( (opt=getopt(argc,argv,"buf:o:c:rs:e:p:t:j:d:k:")) != -1) {
+    switch (opt) {
+    case 'b':
+      S->binary=true;
+      break;
+    case 'u':
+      S->reduce=true;
+      break;
+    case 'f':
+      if (S->filter!=NULL) Bloomfree(S->filter);
+      S->filter=Bloomread(optarg);
+      break;
+    case 'o':
+      S->outfile=optarg;
+      break;
+    case 'c':
+      if (sscanf(optarg,"%lf",&S->ckpt)!=1 || !(S->ckpt>0))
+        error(1, 0, "<seconds> must be positive");
+      break;
+    case 'r':
+      S->resume=true;
+      break;
+    case 's':
+      if (sscanf(optarg,"%u/%u",&S->shard,&S->nshards)!=2 || S->shard==0
+          || S->shard>S->nshards)
+        error(1, 0, "<shard> must be i/m with 1 <= i <= m");
+      break;
+    case 'e':
+      if (sscanf(optarg,"%lu",&S->probes)!=1 || S->probes==0)
+        error(1, 0, "<probes> must be a positive integer");
+      break;
+    case 'p':
+      if (sscanf(optarg,"%lf",&S->progress)!=1 || !(S->progress>0))
+        error(1, 0, "<seconds> must be positive");
+      break;
+    case 't':
+      S->statsfile=optarg;
+      break;
+    case 'j':
+      if (sscanf(optarg,"%u",&S->nthreads)!=1 || S->nthreads==0)
+        error(1, 0, "<threads> must be a positive integer");
+      break;
+    case 'd':
+      if (sscanf(optarg,"%u",&S->depth)!=1)
+        error(1, 0, "<depth> must be a nonnegative integer");
+      break;
+    case 'k':
+      if (!unrestricted)
+        error(1, 0, "-k applies to unrestricted searches only");
+      if (strcmp(optarg,"A")!=0 && strcmp(optarg,"B")!=0)
+        error(1, 0, "<side> must be A or B");
+      S->kind=optarg[0]=='A' ? 'a' : 'b';
+      break;
+    default:
+      error(1, 0, "usage -- %s %s[-b] [-u] [-f filter] [-o out_file "
+            "[-c seconds] [-r]] [-s i/m] [-e probes] [-p seconds] "
+            "[-t stats_file] [-j threads] [-d depth] <length>",
+            basename(argv[0]),side);
+    }
+  }
+  if (optind!=argc-1)
+    error(1, 0, "usage -- %s %s[-b] [-u] [-f filter] [-o out_file "
+          "[-c seconds] [-r]] [-s i/m] [-e probes] [-p seconds] "
+          "[-t stats_file] [-j threads] [-d depth] <length>",
+          basename(argv[0]),side);
+  if (sscanf(argv[optind],"%u",&S->n)!=1) /* read in string length */
+    error(1, errno, "sscanf failed");
+  if (S->n==0 || S->n&1U) /* string length must be positive and even */
+    error(1, 0, "<length> must be a positive even integer");
+  if (S->binary && S->n>BINMAXN)
+    error(1, 0, "binary records require <length> <= %d", BINMAXN);
+  if ((S->ckpt>0 || S->resume) && S->outfile==NULL)
+    error(1, 0, "checkpoints require an output file (-o)");
+  if (S->resume && S->ckpt==0) S->ckpt=CKPT_SECONDS;
+  if (S->filter!=NULL && Bloomlength(S->filter)!=S->n)
+    error(1, 0, "the filter is for strings of length %u",
+          Bloomlength(S->filter));
+# if !HAVE_PTHREAD
+  S->nthreads=1;
+# endif
+}
+
+/**
+ * @brief Run a parallel fixed content bracelet search.
+ *
+ * Splits the recursion trees of all content classes into subtree tasks and
+ * runs them on a work-stealing pool of <b><tt>S->nthreads</tt></b> workers.
+ * Each worker writes its output through a buffer of its own (see output.c).
+ * If <b><tt>S->join</tt></b> is set, the strings are not written: each one is
+ * matched against the index instead, and only its Legendre pairs are written
+ * (see pairseq).
+ *
+ * The output goes to <b><tt>S->outfile</tt></b>, or to stdout if it is NULL.
+ * If <b><tt>S->ckpt</tt></b> is positive, a checkpoint is saved that many
+ * seconds apart, and removed once the search completes. If
+ * <b><tt>S->resume</tt></b> is set, the search continues from the checkpoint.
+ * If <b><tt>S->nshards</tt></b> exceeds 1, only the tasks of shard
+ * <b><tt>S->shard</tt></b> are run. If <b><tt>S->progress</tt></b> is
+ * positive, progress is reported that many seconds apart; if it is, or if
+ * <b><tt>S->statsfile</tt></b> is set, a summary of the counters of the
+ * workers (see stats_t) is written as one line of JSON at the end.
+ *
+ * @param[in,out] S search parameters
+ */
+void Search(search_t *S)
+{
+  ctx_t ctx={.S=S,.fp=stdout};
+  off_t offset=0;
+
+  if (S->ckpt>0) {
+    ctx.ckpt=(char*)malloc(strlen(S->outfile)+6);
+    sprintf(ctx.ckpt,"%s.ckpt",S->outfile);
+  }
+  if (S->resume) {
+    offset=ckptread(&ctx);
+    if ( (ctx.fp=fopen(S->outfile,"r+b"))==NULL )
+      error(1, errno, "failed to open %s", S->outfile);
+    if (ftruncate(fileno(ctx.fp),offset)!=0 || fseeko(ctx.fp,0,SEEK_END)!=0)
+      error(1, errno, "failed to truncate %s", S->outfile);
+  }
+  else if (S->outfile!=NULL && (ctx.fp=fopen(S->outfile,"wb"))==NULL)
+    error(1, errno, "failed to open %s", S->outfile);
+
+  if (S->binary && S->join==NULL && !S->resume) Binheader(ctx.fp,S->kind,S->n);
+  runsearch(S,&ctx);
+
+  if (ctx.fp!=stdout && fclose(ctx.fp)!=0)
+    error(1, errno, "failed to close %s", S->outfile);
+  if (ctx.ckpt!=NULL) {
+    remove(ctx.ckpt);
+    free(ctx.ckpt);
+    free(ctx.done);
+  }
+}
+
+/**
+ * @brief Run a parallel fixed content bracelet search into an index.
+ *
+ * Same as Search, but the strings are stored in a hash table keyed on their
+ * correlations (see join.c) instead of being written. Each worker fills a
+ * table of its own; the tables are merged at the end.
+ *
+ * @param[in,out] S search parameters
+ *
+ * @retval index Return the index of the strings (free with Joinfree).
+ */
+join_t *Searchindex(search_t *S)
+{
+  ctx_t ctx={.S=S,.fp=stdout};
+  join_t *J=Joininit(S->n,S->n/2);
+  unsigned i;
+
+  ctx.joins=(join_t**)malloc(S->nthreads*sizeof(join_t*));
+  for (i=0; i<S->nthreads; i++) ctx.joins[i]=Joininit(S->n,S->n/2);
+  runsearch(S,&ctx);
+  for (i=0; i<S->nthreads; i++) {
+    Joinmerge(J,ctx.joins[i]);
+    Joinfree(ctx.joins[i]);
+  }
+  free(ctx.joins);
+  return J;
+}
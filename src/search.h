@@ -0,0 +1,52 @@
+/**
+ * @file search.h
+ * @brief Parallel fixed content bracelet search declarations.
+ * @author Thomas Pender
+ */
+# ifndef SEARCH_H
+# define SEARCH_H
+
+/* std headers */
+# include <stdbool.h>
+
+/* project headers */
+# include <defs.h>
+# include <seq_funcs.h>
+# include <join.h>
+# include <bloom.h>
+
+/**
+ * @brief Initializer of the bracelet structure and sequence arguments of a
+ * content class (string length, class index, bracelet structure, arguments).
+ */
+typedef void (*class_init_t)(unsigned, unsigned, neck_t*, args_t*);
+
+/**
+ * @brief Search parameters.
+ */
+typedef struct {
+  unsigned n;             ///< string length
+  unsigned nclasses;      ///< number of content classes
+  unsigned nthreads;      ///< number of worker threads
+  unsigned depth;         ///< prefix length of the subtree tasks (0: automatic)
+  class_init_t classinit; ///< content class initializer
+  char kind;              ///< kind ('A', 'B', or 'a', 'b' if unrestricted)
+  bool binary;            ///< whether records are binary (see BINRECORD)
+  bool reduce;            ///< reduce by the class symmetries (see Argsym)
+  join_t *join;           ///< partners the strings are matched against, or NULL
+  bloom_t *filter;        ///< filter of partner correlations, or NULL
+  const char *outfile;    ///< output file, or NULL for stdout
+  double ckpt;            ///< seconds between checkpoints (0: no checkpoints)
+  bool resume;            ///< whether to resume from the checkpoint of outfile
+  unsigned shard;         ///< shard of the search run (1..nshards)
+  unsigned nshards;       ///< number of shards the search is split into
+  unsigned long probes;   ///< probes per content class of Estimate (0: search)
+  double progress;        ///< seconds between progress reports (0: none)
+  const char *statsfile;  ///< file of the reports, or NULL for stderr
+} search_t;
+
+void Searchopts(int, char**, search_t*);
+void Search(search_t*);
+join_t *Searchindex(search_t*);
+
+# endif
@@ -9,14 +9,25 @@
 # include <stdio.h>
 # include <stdlib.h>
 # include <stddef.h>
+# include <stdint.h>
+# include <string.h>
+# include <math.h>
+# include <error.h>
+# include <errno.h>
 
 /* project headers */
 # include <seq_funcs.h>
 # include <defs.h>
+# include <join.h>
+# include <bloom.h>
 
 # define MOD 3       ///< reduction modulo 4 (e.g., <b><tt>x & MOD</tt></b>)
 # define ERR 0.00001 ///< floating point estimate
 # define PI 3.14159265358979
+# define ALIGN 32    ///< alignment of the character and PSD tables in bytes
+
+/** @brief Inlined into every caller, so that constant lengths propagate. */
+# define KERNEL_INLINE static inline __attribute__((always_inline))
 
 /**
  * @brief Perform the group composition of {+1, i, -1, j}.
@@ -39,32 +50,108 @@ unsigned quatmult(const unsigned a, const unsigned b)
 /**
  * @brief Periodic auto-correlation of sequence.
  *
- * @param[in] a sequence
+ * This is the scalar reference of corrbits, used for lengths > 64 and when
+ * configured with <b><tt>--enable-scalar-corr</tt></b>.
+ *
  * @param[in] j periodic auto-correlation at shift \b j
- * @param[in,out] args user defined sequence arguments
+ * @param[in,out] args user defined sequence arguments (<b><tt>args->y</tt></b>
+ * holds the whole sequence)
  *
  * @retval correlation <b>j</b>-th periodic auto-correlation or length+1 if it is
  * nonreal.
  */
 static
-int corr(const unsigned *a, size_t j, args_t *args)
+int corr(size_t j, args_t *args)
 {
-  int *vec=(int*)calloc(K,sizeof(int)), diff;
-  for (size_t i=0,J; i<args->n; i++) {
+  int re=0, im=0;
+  unsigned v, *y=args->y;
+  size_t i,J;
+  for (i=0; i<args->n; i++) {
     J=i+j;
     J=(J<args->n) ? J : (J-args->n);
-    vec[quatmult(args->nummap[a[i+1]],
-                 args->nummap[a[J+1]])]++;
+    v=quatmult(y[i+1],y[J+1]);
+    re+=(int)(~v&1U)*(1-(int)(v&2U));
+    im+=(int)(v&1U)*(1-(int)(v&2U));
   }
-  if (vec[1]!=vec[3]) diff=(int)args->n+1;
-  else diff=vec[0]-vec[2];
-  free(vec);
-  return diff;
+  if (im!=0) return (int)args->n+1;
+  return re;
+}
+
+/**
+ * @brief Periodic auto-correlation of sequence from its bit planes.
+ *
+ * The differences y_{i} - y_{i+j} (mod 4) of all pairs at shift \b j are
+ * formed bitwise from the planes and their rotation by \b j, and the
+ * correlation is read off the popcounts of the four difference classes.
+ * Requires length <= 64 (see arginit).
+ *
+ * @param[in] j periodic auto-correlation at shift \b j
+ * @param[in] args user defined sequence arguments
+ * @param[in] n string length
+ *
+ * @retval correlation <b>j</b>-th periodic auto-correlation or length+1 if it is
+ * nonreal.
+ */
+KERNEL_INLINE
+int corrbits(size_t j, const args_t *args, const unsigned n)
+{
+  const uint64_t lo=args->lo, hi=args->hi,
+    mask=n>=64 ? ~(uint64_t)0 : ((uint64_t)1<<n)-1;
+  uint64_t blo, bhi, d0, d1;
+
+  blo=((lo>>j)|(lo<<(n-j)))&mask; /* bit i holds y_{i+j} */
+  bhi=((hi>>j)|(hi<<(n-j)))&mask;
+  d0=lo^blo;
+  d1=hi^bhi^(~lo&blo); /* borrow of the low bit */
+  if (__builtin_popcountll(~d1&d0)!=__builtin_popcountll(d1&d0))
+    return (int)n+1;
+  return __builtin_popcountll(~d1&~d0&mask)-__builtin_popcountll(d1&~d0);
+}
+
+/* decimal digits of v at s, returns the end of the digits */
+static inline
+char *fmtint(char *s, int v)
+{
+  char digits[12];
+  unsigned u=v<0 ? -(unsigned)v : (unsigned)v;
+  size_t i=0;
+  if (v<0) *s++='-';
+  do digits[i++]=(char)('0'+u%10U); while ( (u/=10U)!=0 );
+  while (i>0) *s++=digits[--i];
+  return s;
+}
+
+/* binary record of the sequence at s (see BINRECORD), returns its end */
+static
+char *fmtbinary(char *s, const unsigned *a, const args_t *args)
+{
+  size_t i, nb=(args->n+3)/4;
+  *s++=(char)args->cls;
+  for (i=0; i<nb; i++) s[i]=0;
+  for (i=0; i<args->n; i++)
+    s[i>>2U]=(char)(s[i>>2U]|(args->nummap[a[i+1]]<<(2*(i&3U))));
+  s+=nb;
+  for (i=1; i<=args->m; i++) *s++=(char)(signed char)args->corrs[i];
+  return s;
+}
+
+/* string as text and its correlations as a join key (see join.c) */
+static inline
+void fmtkey(char *seq, signed char *key, const unsigned *a, const args_t *args)
+{
+  size_t i;
+  for (i=1; i<=args->n; i++) seq[i-1]=(char)('0'+args->nummap[a[i]]);
+  seq[args->n]='\0';
+  for (i=1; i<=args->m; i++) key[i-1]=(signed char)args->corrs[i];
 }
 
 /**
  * @brief Method to print sequence.
  *
+ * The line, or the binary record if <b><tt>args->binary</tt></b> is set, is
+ * formatted into the output buffer <b><tt>args->out</tt></b> (see output.c),
+ * or printed to stdout if there is none.
+ *
  * @param[in] a sequence
  * @param[in] _args user defined sequence arguments
  */
@@ -72,10 +159,126 @@ void printseq(const unsigned *a, const void *_args)
 {
   size_t i;
   args_t *args=(args_t*)_args;
-  for (i=1; i<=args->n; i++) printf("%u",args->nummap[a[i]]);
-  printf(" ");
-  for (i=1; i<args->l; i++) printf("%d,",args->corrs[i]);
-  printf("%d\n",args->corrs[args->l]);
+  char *s;
+
+  STATINC(args->stats,emitted);
+  if (args->out==NULL) {
+    if (args->binary) {
+      char rec[BINRECORD(args->n,args->m)];
+      fwrite(rec,1,(size_t)(fmtbinary(rec,a,args)-rec),stdout);
+      return;
+    }
+    for (i=1; i<=args->n; i++) printf("%u",args->nummap[a[i]]);
+    printf(" ");
+    for (i=1; i<args->m; i++) printf("%d,",args->corrs[i]);
+    printf("%d\n",args->corrs[args->m]);
+    return;
+  }
+
+  if (args->binary) {
+    s=Outreserve(args->out,BINRECORD(args->n,args->m));
+    Outcommit(args->out,fmtbinary(s,a,args));
+    return;
+  }
+
+  s=Outreserve(args->out,args->n+12*(size_t)args->m+2);
+  for (i=1; i<=args->n; i++) *s++=(char)('0'+args->nummap[a[i]]);
+  *s++=' ';
+  for (i=1; i<args->m; i++) {
+    s=fmtint(s,args->corrs[i]);
+    *s++=',';
+  }
+  s=fmtint(s,args->corrs[args->m]);
+  *s++='\n';
+  Outcommit(args->out,s);
+}
+
+/**
+ * @brief Method to store sequence in an index.
+ *
+ * The sequence is added to the hash table <b><tt>args->join</tt></b> under its
+ * correlations (see Searchindex); nothing is printed.
+ *
+ * @param[in] a sequence
+ * @param[in] _args user defined sequence arguments
+ */
+void indexseq(const unsigned *a, const void *_args)
+{
+  const args_t *args=(const args_t*)_args;
+  char seq[args->n+1];
+  signed char key[args->m];
+
+  STATINC(args->stats,emitted);
+  fmtkey(seq,key,a,args);
+  Joinadd(args->join,key,seq);
+}
+
+/**
+ * @brief Method to print the Legendre pairs of sequence.
+ *
+ * The partners of the sequence are looked up in the index
+ * <b><tt>args->join</tt></b> under the complement -2 - R of its correlations
+ * R, and every pair is formatted into the output buffer
+ * <b><tt>args->out</tt></b>, or printed to stdout if there is none. The
+ * sequence is printed first.
+ *
+ * @param[in] a sequence
+ * @param[in] _args user defined sequence arguments
+ */
+void pairseq(const unsigned *a, const void *_args)
+{
+  const args_t *args=(const args_t*)_args;
+  char seq[args->n+1], *s;
+  signed char key[args->m], comp[args->m];
+  size_t id, next;
+
+  STATINC(args->stats,emitted);
+  fmtkey(seq,key,a,args);
+  Joincomplement(key,comp,args->m);
+  for (id=Joinfind(args->join,comp); id!=0; id=next) {
+    const char *b=Joinseq(args->join,id,&next);
+    if (args->out==NULL) {
+      Pairprint(stdout,seq,key,b,comp,args->m);
+      continue;
+    }
+    s=Outreserve(args->out,PAIRSIZE(2*args->m));
+    Outcommit(args->out,Pairformat(s,seq,key,b,comp,args->m));
+  }
+}
+
+/* body of arginit for strings of length n */
+KERNEL_INLINE
+void argfill(const unsigned *a, args_t *args, const unsigned n)
+{
+  const unsigned l=n>>1U;
+  size_t i;
+
+  STATINC(args->stats,strings);
+  args->seq=a;
+  for (i=1; i<=n; i++) args->y[i]=args->nummap[a[i]];
+  args->realcorrs=true;
+# if !SCALAR_CORR
+  if (n<=64) {
+    uint64_t lo=0, hi=0;
+    for (i=0; i<n; i++) {
+      lo|=(uint64_t)(args->y[i+1]&1U)<<i;
+      hi|=(uint64_t)(args->y[i+1]>>1U)<<i;
+    }
+    args->lo=lo;
+    args->hi=hi;
+    for (i=1; i<=l; i++)
+      if ( (args->corrs[i]=corrbits(i,args,n))>(int)n ) {
+        args->realcorrs=false;
+        break;
+      }
+    return;
+  }
+# endif
+  for (i=1; i<=l; i++)
+    if ( (args->corrs[i]=corr(i,args))>(int)n ) {
+      args->realcorrs=false;
+      break;
+    }
 }
 
 /**
@@ -90,15 +293,170 @@ void printseq(const unsigned *a, const void *_args)
  */
 void arginit(const unsigned *a, void *_args)
 {
+  argfill(a,(args_t*)_args,((args_t*)_args)->n);
+}
+
+/**
+ * @brief Initialize auxilary data of strings of two real letters.
+ *
+ * Same as arginit for strings whose letters map to 0 and 2 (entries 1 and
+ * -1). The correlations are real and
+ * computed from the bits of the letters 2 alone: the correlation at shift j
+ * is N less twice the number of entries differing from their j-th successor.
+ *
+ * @param[in] a sequence
+ * @param[in,out] _args user defined sequence arguments
+ */
+void argbinary(const unsigned *a, void *_args)
+{
+  args_t *args=(args_t*)_args;
+  const unsigned n=args->n, l=n>>1U;
   size_t i;
+
+# if !SCALAR_CORR
+  if (n<=64) {
+    const uint64_t mask=n>=64 ? ~(uint64_t)0 : ((uint64_t)1<<n)-1;
+    uint64_t x=0, r;
+
+    STATINC(args->stats,strings);
+    args->seq=a;
+    for (i=0; i<n; i++) x|=(uint64_t)(args->nummap[a[i+1]]>>1U)<<i;
+    args->lo=0;
+    args->hi=x;
+    args->realcorrs=true;
+    for (i=1; i<=l; i++) {
+      r=((x>>i)|(x<<(n-i)))&mask;
+      args->corrs[i]=(int)n-2*__builtin_popcountll(x^r);
+    }
+    return;
+  }
+# endif
+  (void)l;
+  (void)i;
+  argfill(a,args,n);
+}
+
+/**
+ * @brief Drop the last fixed position.
+ *
+ * The character sums of each prefix length are kept in rows of their own (see
+ * argpushcomplex), so only the prefix length is restored.
+ *
+ * @param[in] a sequence prefix
+ * @param[in] t last fixed position
+ * @param[in,out] _args user defined sequence arguments
+ */
+void argpop(const unsigned *a, unsigned t, void *_args)
+{
+  (void)a;
+  ((args_t*)_args)->depth=t-1;
+}
+
+/**
+ * @brief Initialize auxilary data of unrestricted strings.
+ *
+ * The correlations c_j of strings with nonreal ones are Gaussian integers,
+ * with c_{N-j} the conjugate of c_j. They are computed exactly, as counts of
+ * the four differences y_{i} - y_{i+j} (mod 4) at each shift j <= N/2 (see
+ * corrbits), and recorded as the N-1 integers
+ * <b><tt>args->corrs[j]</tt></b> = Re c_j + Im c_j, j = 1..N-1, from which
+ * c_j = (corrs[j] + corrs[N-j])/2 + i (corrs[j] - corrs[N-j])/2. Legendre
+ * pairs are exactly the pairs of strings whose recorded correlations sum to
+ * -2 at every shift, as for real ones, so they join the same way (see
+ * join.c). <b><tt>args->realcorrs</tt></b> tells whether the correlations
+ * are real.
+ *
+ * @param[in] a sequence
+ * @param[in,out] _args user defined sequence arguments
+ */
+void argcomplex(const unsigned *a, void *_args)
+{
   args_t *args=(args_t*)_args;
+  const unsigned n=args->n, l=args->l;
+  unsigned *y=args->y, v;
+  int *corrs=args->corrs, re, im, real=1;
+  size_t i, j;
 
-  args->realcorrs=true;
-  for (i=1; i<=args->l; i++)
-    if ( (args->corrs[i]=corr(a,i,args))>(int)args->n ) {
-      args->realcorrs=false;
-      break;
+  STATINC(args->stats,strings);
+  args->seq=a;
+  for (i=args->depth+1; i<=n; i++) y[i]=args->nummap[a[i]];
+# if !SCALAR_CORR
+  if (n<=64) {
+    const uint64_t mask=n>=64 ? ~(uint64_t)0 : ((uint64_t)1<<n)-1;
+    uint64_t lo=0, hi=0, blo, bhi, d0, d1;
+    for (i=0; i<n; i++) {
+      lo|=(uint64_t)(y[i+1]&1U)<<i;
+      hi|=(uint64_t)(y[i+1]>>1U)<<i;
+    }
+    for (j=1; j<=l; j++) {
+      blo=((lo>>j)|(lo<<(n-j)))&mask;
+      bhi=((hi>>j)|(hi<<(n-j)))&mask;
+      d0=lo^blo;
+      d1=hi^bhi^(~lo&blo);
+      re=__builtin_popcountll(~d1&~d0&mask)-__builtin_popcountll(d1&~d0);
+      im=__builtin_popcountll(~d1&d0)-__builtin_popcountll(d1&d0);
+      corrs[j]=re+im;
+      corrs[n-j]=re-im; /* the same entry at j = l, where im = 0 */
+      real&=im==0;
     }
+    args->realcorrs=real;
+    return;
+  }
+# endif
+  for (j=1; j<=l; j++) {
+    for (i=0, re=im=0; i<n; i++) {
+      v=quatmult(y[i+1],y[(i+j)%n+1]);
+      re+=(int)(~v&1U)*(1-(int)(v&2U));
+      im+=(int)(v&1U)*(1-(int)(v&2U));
+    }
+    corrs[j]=re+im;
+    corrs[n-j]=re-im;
+    real&=im==0;
+  }
+  args->realcorrs=real;
+}
+
+/**
+ * @brief Add the character sum terms of a newly fixed position of an
+ * unrestricted string.
+ *
+ * The character sums of the prefix are extended by position \b t. The
+ * remaining positions have modulus 1, so by the triangle inequality the prefix
+ * fails complexpsdtest once a character sum at a frequency k <= N/2 exceeds
+ * \sqrt{2N+2} by more than the number of remaining positions. Only the
+ * necklaces of UBclassinit are pruned this way: on the bracelets of the other
+ * classes, the updates at every node cost more than the pruning saves.
+ *
+ * @param[in] a sequence prefix
+ * @param[in] t newly fixed position
+ * @param[in,out] _args user defined sequence arguments
+ *
+ * @retval feasible Return whether the prefix may still pass the PSD test.
+ */
+bool argpushcomplex(const unsigned *a, unsigned t, void *_args)
+{
+  args_t *args=(args_t*)_args;
+  const unsigned n=args->n, l=args->l, x=args->nummap[a[t]];
+  const size_t w=args->w;
+  const double lim=args->psdlim[t],
+    *restrict phre=args->phre+(x*(n+2)+t)*w,
+    *restrict phim=args->phim+(x*(n+2)+t)*w,
+    *restrict pre=args->sre+(t-1)*w, *restrict pim=args->sim+(t-1)*w;
+  double *restrict sre=args->sre+t*w, *restrict sim=args->sim+t*w;
+  size_t j;
+
+  args->depth=t;
+  args->y[t]=x;
+
+  /* add i^x w^{k(t-1)} to the sums of the shorter prefix */
+  for (j=0; j<w; j++) { /* whole rows, so that loads meet whole stores */
+    sre[j]=pre[j]+phre[j];
+    sim[j]=pim[j]+phim[j];
+  }
+  if (t*t<=lim) return true; /* |sums| <= t, no frequency can fail yet */
+  for (j=1; j<=l; j++)
+    if (sre[j]*sre[j]+sim[j]*sim[j]>lim) return false;
+  return true;
 }
 
 /**
@@ -112,8 +470,7 @@ void arginit(const unsigned *a, void *_args)
  */
 void argfree(void *_args)
 {
-  args_t *args=(args_t*)_args;
-  if (args->corrs!=NULL) free(args->corrs);
+  (void)_args; /* the arrays are freed with the arguments (see Argfree) */
 }
 
 /**
@@ -124,13 +481,51 @@ void argfree(void *_args)
 bool realcorrs(const void *_args)
 {
   args_t *args=(args_t*)_args;
+  if (!args->realcorrs) STATINC(args->stats,realrejects);
   return args->realcorrs;
 }
 
+/* square norms of the character sums at all frequencies into args->psd */
+KERNEL_INLINE
+void psdnorms(args_t *args, const unsigned n)
+{
+  const unsigned l=n>>1U;
+  const size_t w=PSDROW(l);
+  double *restrict psd=args->psd, c;
+  size_t i,j;
+
+  for (i=0; i<w; i++) psd[i]=n;
+  for (j=1; j<=l; j++) {
+    const double *restrict row=args->psdtable+j*w;
+    c=args->corrs[j];
+    for (i=0; i<w; i++) psd[i]+=c*row[i];
+  }
+}
+
+/* body of psdtest for strings of length n */
+KERNEL_INLINE
+bool psdtestn(args_t *args, const unsigned n)
+{
+  const double N=2.0*n+2+ERR;
+  const unsigned l=n>>1U;
+  size_t i;
+
+  psdnorms(args,n);
+  for (i=1; i<=l; i++)
+    if (args->psd[i]>N) {
+      STATINC(args->stats,psdtestrejects);
+      return false;
+    }
+  return true;
+}
+
 /**
  * @brief Power spectral density test (bounded square norms of nonprincipal
  * character sums).
  *
+ * The square norms are computed from the correlations (see Psdtable), at all
+ * frequencies at once.
+ *
  * @param[in] _args user defined sequence arguments
  *
  * @retval square_norm_check Return whether the nonprincipal character sums of
@@ -138,42 +533,237 @@ bool realcorrs(const void *_args)
  * a Legendre pair.
  */
 bool psdtest(const void *_args)
+{
+  return psdtestn((args_t*)_args,((const args_t*)_args)->n);
+}
+
+/**
+ * @brief Power spectral density test of unrestricted strings.
+ *
+ * The character sums of a string with nonreal correlations have different
+ * square norms at the frequencies k and N-k. With R_k the real part of the
+ * transform of the correlations at k (see Psdtable) and I_k that of their
+ * imaginary parts, the square norms are R_k - I_k and R_k + I_k, so both are
+ * bounded by 2N+2 iff R_k + |I_k| is, for k = 1..N/2. The correlations are
+ * recovered from those recorded by argcomplex. Each frequency takes a pass
+ * over the correlations, so the one that has rejected most strings so far is
+ * tested first.
+ *
+ * @param[in] _args user defined sequence arguments
+ *
+ * @retval square_norm_check Return whether the nonprincipal character sums
+ * of the given sequence are bounded above by 2N+2 at all N-1 frequencies.
+ */
+bool complexpsdtest(const void *_args)
 {
   args_t *args=(args_t*)_args;
-  double sum;
-  size_t i,j;
-  int N=2*(int)args->n+2;
-  for (i=1; i<=args->l; i++) { /* i-th psd */
-    sum=args->n;
-    for (j=1; j<args->l; j++) sum+=args->corrs[j]*args->psdtable[i][j];
-    sum+=args->corrs[args->l]*args->psdtable[i][args->l];
-    if (sum-N>ERR) return false;
+  const unsigned n=args->n, l=args->l;
+  const size_t w=args->w;
+  const double N=2.0*n+2+ERR;
+  const int *corrs=args->corrs;
+  double re[l+1], im[l+1], R, J;
+  size_t i, j, k;
+
+  for (j=1; j<=l; j++) {
+    re[j]=0.5*(corrs[j]+corrs[n-j]);
+    im[j]=0.5*(corrs[j]-corrs[n-j]);
+  }
+  for (k=0; k<l; k++) {
+    i=k==0 ? args->psdfirst : k==args->psdfirst ? l : k; /* most rejections first */
+    R=n;
+    J=0;
+    for (j=1; j<=l; j++) {
+      R+=re[j]*args->psdtable[j*w+i];
+      J+=im[j]*args->psdsin[j*w+i];
+    }
+    if (R+fabs(J)>N) {
+      if (++args->psdrejects[i]>args->psdrejects[args->psdfirst])
+        args->psdfirst=(unsigned)i;
+      STATINC(args->stats,psdtestrejects);
+      return false;
+    }
+  }
+  return true;
+}
+
+/** @cond */
+
+/* zeroed array of doubles aligned for vector loads */
+static
+double *dalloc(size_t count)
+{
+  size_t size=(count*sizeof(double)+ALIGN-1)/ALIGN*ALIGN;
+  double *p=(double*)aligned_alloc(ALIGN,size);
+  if (p==NULL) error(1, errno, "aligned_alloc failed");
+  for (size_t i=0; i<count; i++) p[i]=0;
+  return p;
+}
+
+/* zeroed array of the arguments */
+static
+void *zalloc(size_t count, size_t size)
+{
+  void *p=calloc(count,size);
+  if (p==NULL) error(1, errno, "calloc failed");
+  return p;
+}
+
+/** @endcond */
+
+/**
+ * @brief Check if the sequence may have a partner.
+ *
+ * Partners have correlations -2 - R at every shift, where R are the
+ * correlations of the sequence. The test fails if the filter
+ * <b><tt>args->filter</tt></b> (see bloom.c), built from the correlations of
+ * the other side, certainly does not hold them.
+ *
+ * @param[in] _args user defined sequence arguments
+ *
+ * @retval partner Return whether the sequence may form part of a Legendre
+ * pair with a string of the filter.
+ */
+bool filtertest(const void *_args)
+{
+  const args_t *args=(const args_t*)_args;
+  signed char comp[args->l];
+  for (size_t i=1; i<=args->l; i++)
+    comp[i-1]=(signed char)(-2-args->corrs[i]);
+  if (Bloomtest(args->filter,comp)) return true;
+  STATINC(args->stats,filterrejects);
+  return false;
+}
+
+/** @cond */
+
+struct sym {
+  unsigned map[K+1]; /* map of the letters */
+  unsigned u;        /* decimation */
+};
+
+/* whether some rotation or reflection of b is less than a (entries 0..n-1) */
+static
+bool dihedralless(const unsigned *b, const unsigned *a, unsigned n)
+{
+  unsigned r, i, x=0;
+  for (r=0; r<n; r++) {
+    for (i=0; i<n && (x=b[(r+i)%n])==a[i]; i++) ;
+    if (i<n && x<a[i]) return true;
+    for (i=0; i<n && (x=b[(r+n-i)%n])==a[i]; i++) ;
+    if (i<n && x<a[i]) return true;
+  }
+  return false;
+}
+
+/** @endcond */
+
+/**
+ * @brief Test for orbit representatives under the symmetries of the class.
+ *
+ * Bracelets are the least strings of their orbits under D_N (rotations and
+ * reflection). A string passes if no symmetry of
+ * <b><tt>args->syms</tt></b> (see Argsym) maps it to a string with a lesser
+ * rotation or reflection, i.e. if it is also the least string of its orbit
+ * under the group generated by D_N and the symmetries.
+ *
+ * @param[in] _args user defined sequence arguments
+ *
+ * @retval symtest Return whether the string is an orbit representative.
+ */
+bool symtest(const void *_args)
+{
+  const args_t *args=(const args_t*)_args;
+  const unsigned n=args->n, *a=args->seq+1;
+  unsigned b[n];
+
+  for (unsigned s=0; s<args->nsyms; s++) {
+    const struct sym *g=args->syms+s;
+    for (size_t i=0; i<n; i++) b[i]=g->map[a[(size_t)g->u*i%n]];
+    if (dihedralless(b,a,n)) {
+      STATINC(args->stats,symrejects);
+      return false;
+    }
   }
   return true;
 }
 
 /**
  * @brief Table containing distinct square norms of nonprincipal character sums.
+ *
+ * Entry <b><tt>j*w+i</tt></b> (w = PSDROW(n/2)) is the coefficient of the
+ * correlation at shift j in the square norm at frequency i, so that the square
+ * norms at all frequencies are accumulated row by row.
+ *
  * @param[in] n sequence length
- * @retval table Contains distinct square norms of nonprincipal character sums.
+ * @retval table Contains distinct square norms of nonprincipal character sums
+ * (free with free).
  */
-double **Psdtable(unsigned n)
+double *Psdtable(unsigned n)
 {
   size_t i,j;
-  unsigned l=n>>1U;
-  double **table=(double**)malloc((l+1)*sizeof(double*));
-  table[0]=NULL;
+  unsigned l=n>>1U, w=PSDROW(l);
+  double *table=dalloc((size_t)(l+1)*w);
   for (i=1; i<=l; i++) {
-    table[i]=(double*)calloc(l+1,sizeof(double));
-    table[i][0]=1;
-    for (j=1; j<l; j++) {
-      table[i][j]=2*creal(cexp(2*PI*I*i*j/n));
-    }
-    table[i][l]=creal(cexp(2*PI*I*i*l/n));
+    table[i]=1;
+    for (j=1; j<l; j++) table[j*w+i]=2*creal(cexp(2*PI*I*i*j/n));
+    table[l*w+i]=creal(cexp(2*PI*I*i*l/n));
   }
   return table;
 }
 
+/**
+ * @brief Allocate user defined sequence arguments.
+ *
+ * Allocates the correlations, prefix data, letter map, table of square norms
+ * and character tables of the arguments of length <b><tt>args->n</tt></b>.
+ *
+ * @param[in,out] args user defined sequence arguments
+ * @param[in] k string arity
+ */
+void Argalloc(args_t *args, unsigned k)
+{
+  size_t t,i,j,w,x;
+  double sum, *psdsin, *phre, *phim, *psdlim;
+  comp z;
+
+  args->l=args->n>>1U;
+  args->m=args->l;
+  args->depth=0;
+  args->realcorrs=false;
+  args->corrs=(int*)zalloc(args->n,sizeof(int));
+  args->w=PSDROW(args->l);
+  args->y=(unsigned*)zalloc(args->n+1,sizeof(unsigned));
+  args->nummap=(unsigned*)zalloc(k+1,sizeof(unsigned));
+  args->psdtable=Psdtable(args->n);
+  args->psd=dalloc(args->w);
+  args->psdrejects=(unsigned long*)zalloc(args->l+1,sizeof(unsigned long));
+  args->psdfirst=1;
+
+  w=args->w;
+  args->psdsin=psdsin=dalloc((args->l+1)*w);
+  args->phre=phre=dalloc(K*(args->n+2)*w);
+  args->phim=phim=dalloc(K*(args->n+2)*w);
+  args->sre=dalloc((args->n+1)*w);
+  args->sim=dalloc((args->n+1)*w);
+  args->psdlim=psdlim=dalloc(args->n+1);
+  for (i=1; i<=args->l; i++) /* 2 sin(2 pi i j/N), zero at j = l */
+    for (j=1; j<args->l; j++)
+      psdsin[j*w+i]=2*sin(2*PI*(double)((i*j)%args->n)/args->n);
+  for (t=1; t<=args->n; t++)
+    for (j=1; j<=args->l; j++) {
+      z=cexp(2*PI*I*(double)((j*(t-1))%args->n)/args->n);
+      for (x=0; x<K; x++) { /* rotate by i^x */
+        phre[(x*(args->n+2)+t)*w+j]=creal(z);
+        phim[(x*(args->n+2)+t)*w+j]=cimag(z);
+        z=CMPLX(-cimag(z),creal(z));
+      }
+    }
+  for (t=0; t<=args->n; t++) {
+    sum=(double)(args->n-t)+sqrt(2.0*args->n+2+ERR);
+    psdlim[t]=sum*sum;
+  }
+}
+
 /**
  * @brief Free user defined sequence arguments.
  *
@@ -183,11 +773,31 @@ void Argfree(args_t *args)
 {
   if (args->nummap!=NULL) free(args->nummap);
   if (args->corrs!=NULL) free(args->corrs);
-  if (args->psdtable!=NULL) {
-    for (size_t i=0; i<=args->l; i++)
-      if (args->psdtable[i]!=NULL) free(args->psdtable[i]);
-    free(args->psdtable);
-  }
+  if (args->y!=NULL) free(args->y);
+  if (args->psd!=NULL) free(args->psd);
+  if (args->psdrejects!=NULL) free(args->psdrejects);
+  if (args->psdtable!=NULL) free((void*)args->psdtable);
+  if (args->psdsin!=NULL) free((void*)args->psdsin);
+  if (args->phre!=NULL) free((void*)args->phre);
+  if (args->phim!=NULL) free((void*)args->phim);
+  if (args->sre!=NULL) free(args->sre);
+  if (args->sim!=NULL) free(args->sim);
+  if (args->psdlim!=NULL) free((void*)args->psdlim);
+  if (args->syms!=NULL) free(args->syms);
+  args->nummap=NULL;
+  args->corrs=NULL;
+  args->y=NULL;
+  args->psd=NULL;
+  args->psdrejects=NULL;
+  args->psdtable=NULL;
+  args->psdsin=NULL;
+  args->phre=NULL;
+  args->phim=NULL;
+  args->sre=NULL;
+  args->sim=NULL;
+  args->psdlim=NULL;
+  args->syms=NULL;
+  args->nsyms=0;
 }
 
 /**
@@ -199,4 +809,196 @@ void Neckfree(neck_t *N)
 {
   if (N->num!=NULL) free(N->num);
   if (N->checkfuncs!=NULL) free(N->checkfuncs);
+  if (N->work!=NULL) free(N->work);
+}
+
+/* kernels specialized for the even lengths MINKERNEL..MAXKERNEL (see Kernel) */
+
+/** @cond */
+
+/* realcorrs followed by psdtest, as one check */
+KERNEL_INLINE
+bool realpsdn(args_t *args, const unsigned n)
+{
+  if (!args->realcorrs) {
+    STATINC(args->stats,realrejects);
+    return false;
+  }
+  return psdtestn(args,n);
+}
+
+# if !SCALAR_CORR
+
+# define KERNEL(N) \
+  static void arginit##N(const unsigned *a, void *_args) \
+  { argfill(a,(args_t*)_args,N); } \
+  static bool psdtest##N(const void *_args) \
+  { return psdtestn((args_t*)_args,N); } \
+  static bool realpsd##N(const void *_args) \
+  { return realpsdn((args_t*)_args,N); }
+
+# define KENTRY(N) [N/2]={arginit##N,psdtest##N,realpsd##N}
+
+KERNEL(16) KERNEL(18) KERNEL(20) KERNEL(22) KERNEL(24) KERNEL(26)
+
+static const kernel_t kernels[MAXKERNEL/2+1]={
+  KENTRY(16), KENTRY(18), KENTRY(20), KENTRY(22), KENTRY(24), KENTRY(26)
+};
+
+# endif
+
+/** @endcond */
+
+/**
+ * @brief Check that the periodic auto-correlations are real-valued, then
+ * apply the PSD test.
+ *
+ * Same as realcorrs followed by psdtest, in a single call.
+ *
+ * @param[in] _args user defined sequence arguments
+ *
+ * @retval pass Return whether both checks pass.
+ */
+bool realpsdtest(const void *_args)
+{
+  return realpsdn((args_t*)_args,((const args_t*)_args)->n);
+}
+
+/**
+ * @brief Kernels specialized for a string length.
+ *
+ * The methods are the generic ones compiled for a constant length, so that
+ * every loop over shifts, frequencies or table rows has a constant trip count
+ * and may be unrolled and vectorized, and the tables have constant strides.
+ * Only the lengths where this was measured to pay have kernels: shorter
+ * searches take well under a second, and longer ones were not timed.
+ *
+ * @param[in] n string length
+ *
+ * @retval kernels Return the kernels for length \b n, or NULL if there are
+ * none (odd lengths, lengths outside MINKERNEL..MAXKERNEL and the scalar
+ * correlation engine).
+ */
+const kernel_t *Kernel(unsigned n)
+{
+# if !SCALAR_CORR
+  if (n>=MINKERNEL && n<=MAXKERNEL && !(n&1U)) return &kernels[n/2];
+# else
+  (void)n;
+# endif
+  return NULL;
+}
+
+/**
+ * @brief Switch the methods of a bracelet structure to the kernels of its
+ * string length.
+ *
+ * Dispatches once, when a content class is initialized: generic methods with
+ * kernels of their own (see Kernel) are replaced by them, and the checks
+ * realcorrs and psdtest in a row are fused into one. Other methods are kept.
+ *
+ * @param[in,out] neck bracelet structure
+ */
+void Argkernel(neck_t *neck)
+{
+  const kernel_t *kern=Kernel(neck->n);
+  unsigned i, j;
+
+  for (i=0, j=0; i<neck->ncheckfuncs; i++, j++) {
+    if (neck->checkfuncs[i]==realcorrs && i+1<neck->ncheckfuncs
+        && neck->checkfuncs[i+1]==psdtest) {
+      neck->checkfuncs[j]=kern!=NULL ? kern->realpsdtest : realpsdtest;
+      i++;
+    }
+    else if (neck->checkfuncs[i]==psdtest && kern!=NULL)
+      neck->checkfuncs[j]=kern->psdtest;
+    else neck->checkfuncs[j]=neck->checkfuncs[i];
+  }
+  neck->ncheckfuncs=j;
+  if (kern==NULL) return;
+  if (neck->arginit==arginit) neck->arginit=kern->arginit;
+}
+
+/**
+ * @brief Reduce the strings of a content class by its symmetries.
+ *
+ * Collects the symmetries of the class beyond D_N that keep the periodic
+ * auto-correlations real and their multiset unchanged: the maps x -> x+c and
+ * x -> c-x of the logarithms of i (multiplication by i^c and conjugation
+ * followed by it) that keep the content and the sum of the strings, and, if
+ * <b><tt>decimate</tt></b> is set, the decimations by the units u of Z_N
+ * (u < N/2, as u and N-u differ by a reflection). Decimation permutes the
+ * correlations, so the strings of only one side of a Legendre pair may be
+ * decimated. symtest is appended to the checks, last.
+ *
+ * @param[in,out] neck bracelet structure of the class (before the search)
+ * @param[in,out] args sequence arguments of the class (the symmetries are
+ * freed with Argfree)
+ * @param[in] decimate whether to reduce by decimation as well
+ */
+void Argsym(neck_t *neck, args_t *args, bool decimate)
+{
+  static const int re[4]={1,0,-1,0}, im[4]={0,1,0,-1};
+  const unsigned n=neck->n, k=neck->k;
+  unsigned u, f, x, y, d, e, s, a, b, map[K+1];
+  int sre, sim;
+  bool ok;
+
+  args->syms=(struct sym*)malloc(8*(n/2+1)*sizeof(struct sym));
+  if (args->syms==NULL) error(1, errno, "malloc failed");
+  args->nsyms=0;
+  map[0]=0;
+  for (u=1; u<(decimate ? n/2 : 2); u+=2) {
+    for (a=u, b=n; b!=0; ) { e=a%b; a=b; b=e; } /* gcd(u,n) */
+    if (a!=1) continue;
+    for (f=0; f<8; f++) {
+      ok=true;
+      sre=sim=0;
+      for (x=1; x<=k && ok; x++) {
+        d=args->nummap[x];
+        e=f<4 ? (d+f)&3U : (f-d)&3U;
+        for (y=1; y<=k && args->nummap[y]!=e; y++) ;
+        ok=y<=k && neck->num[y]==neck->num[x];
+        map[x]=y;
+        sre+=(int)neck->num[x]*(re[e]-re[d]);
+        sim+=(int)neck->num[x]*(im[e]-im[d]);
+      }
+      if (!ok || sre!=0 || sim!=0) continue;
+      for (x=1; x<=k && map[x]==x; x++) ;
+      if (u==1 && x>k) continue; /* identity */
+      for (s=0; s<args->nsyms; s++)
+        if (args->syms[s].u==u && memcmp(args->syms[s].map+1,map+1,
+                                         k*sizeof(unsigned))==0)
+          break;
+      if (s<args->nsyms) continue;
+      args->syms[args->nsyms].u=u;
+      for (x=0; x<=k; x++) args->syms[args->nsyms].map[x]=map[x];
+      args->nsyms++;
+    }
+  }
+  if (args->nsyms==0) return;
+  neck->checkfuncs=(check_t*)realloc(neck->checkfuncs,
+                                     (neck->ncheckfuncs+1)*sizeof(check_t));
+  if (neck->checkfuncs==NULL) error(1, errno, "realloc failed");
+  neck->checkfuncs[neck->ncheckfuncs++]=symtest;
+}
+
+/**
+ * @brief Switch a content class to unrestricted strings.
+ *
+ * The strings of the class are no longer required to have real correlations:
+ * they are evaluated by argcomplex and tested by complexpsdtest alone, and N-1
+ * correlations are recorded for each. The content of the class is kept.
+ *
+ * @param[in,out] neck bracelet structure of the class (before the search)
+ * @param[in,out] args sequence arguments of the class
+ */
+void Argcomplex(neck_t *neck, args_t *args)
+{
+  neck->arginit=argcomplex;
+  neck->ncheckfuncs=1;
+  neck->checkfuncs=(check_t*)realloc(neck->checkfuncs,sizeof(check_t));
+  if (neck->checkfuncs==NULL) error(1, errno, "realloc failed");
+  neck->checkfuncs[0]=complexpsdtest;
+  args->m=args->n-1;
 }
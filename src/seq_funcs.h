@@ -9,9 +9,54 @@
 /* std headers */
 # include <complex.h>
 # include <stdbool.h>
+# include <stdint.h>
 
 /* project headers */
 # include <defs.h>
+# include <output.h>
+# include <join.h>
+# include <bloom.h>
+
+/** @brief Row length of the tables indexed by frequency (l+1 rounded up to 4). */
+# define PSDROW(l) (((l)+4U)&~3U)
+
+/**
+ * @brief Counters of a worker.
+ *
+ * Written by the worker alone and read by the progress reporter, with relaxed
+ * loads and stores (see STATINC): no shared atomic updates on the hot path.
+ * Aligned to a cache line so that the counters of two workers never share
+ * one.
+ */
+typedef struct {
+  _Alignas(64) unsigned long nodes; ///< string positions fixed (see neck_t)
+  unsigned long strings;       ///< strings generated (arginit)
+  unsigned long realrejects;   ///< strings rejected by realcorrs
+  unsigned long psdtestrejects; ///< strings rejected by psdtest
+  unsigned long filterrejects; ///< strings rejected by filtertest
+  unsigned long symrejects;    ///< strings rejected by symtest
+  unsigned long emitted;       ///< strings passing every check
+  double done;                 ///< estimated cost of the completed tasks
+} stats_t;
+
+/** @brief Add \b v to counter \b f of the counters \b s of a worker, if any. */
+# define STATADD(s,f,v) do { \
+    if ((s)!=NULL) \
+      __atomic_store_n(&(s)->f,__atomic_load_n(&(s)->f,__ATOMIC_RELAXED)+(v), \
+                       __ATOMIC_RELAXED); \
+  } while (0)
+
+/** @brief Increment counter \b f of the counters \b s of a worker, if any. */
+# define STATINC(s,f) STATADD(s,f,1)
+
+/** @brief Least string length with kernels of its own (see Kernel). */
+# define MINKERNEL 16
+
+/** @brief Largest string length with kernels of its own (see Kernel). */
+# define MAXKERNEL 26
+
+/** @brief Symmetry of a content class (see Argsym). */
+struct sym;
 
 /** @brief complex numbers */
 typedef double complex comp;
@@ -22,22 +67,69 @@ typedef double complex comp;
 typedef struct {
   unsigned n; ///< string length
   unsigned l; ///< length / 2
+  unsigned m; ///< number of correlations recorded (l, or N-1 see argcomplex)
   unsigned *nummap; ///< bijection between letters and logarithms of i
-  int *corrs; ///< sequence periodic auto-correlations
+  int *corrs; ///< sequence periodic auto-correlations (entries 1..m)
   bool realcorrs; ///< whether the periodic auto-correlations are real-valued
-  double **psdtable; ///< distinct square norms of nonprincipal character sums
+  const double *psdtable; ///< square norm terms (see Psdtable)
+  const double *psdsin; ///< their imaginary parts (see complexpsdtest)
+  double *psd; ///< square norms of the character sums (see psdtest)
+  unsigned long *psdrejects; ///< number of rejections at each frequency
+  unsigned psdfirst; ///< frequency tested first by complexpsdtest
+  unsigned depth; ///< number of fixed string positions (see argpushcomplex)
+  unsigned *y; ///< string elements (entries 1..n)
+  const unsigned *seq; ///< string being checked (letters, entries 1..n)
+  uint64_t lo, hi; ///< bit planes of the string (bit i: position i+1)
+  unsigned w; ///< row length of the prefix and PSD tables (see PSDROW)
+  const double *phre; ///< i^x w^{k(t-1)} (block x, row t, column k)
+  const double *phim; ///< their imaginary parts
+  double *sre; ///< character sums of the prefix (row t, column k)
+  double *sim; ///< their imaginary parts
+  const double *psdlim; ///< square norm bound per prefix length
+  outbuf_t *out; ///< output buffer of printseq (NULL: stdout)
+  bool binary; ///< whether printseq writes binary records (see BINRECORD)
+  unsigned cls; ///< content class recorded by binary records
+  join_t *join; ///< index of strings (see indexseq and pairseq)
+  const bloom_t *filter; ///< filter of partner correlations (see filtertest)
+  stats_t *stats; ///< counters of the worker, or NULL
+  struct sym *syms; ///< symmetries the strings are reduced by (see Argsym)
+  unsigned nsyms; ///< number of symmetries
 } args_t;
 
+/**
+ * @brief Methods specialized for a string length (see Kernel).
+ */
+typedef struct {
+  arg_init_t arginit;   ///< arginit
+  check_t psdtest;      ///< psdtest
+  check_t realpsdtest;  ///< realpsdtest
+} kernel_t;
+
 /* functions for neck struct */
 void printseq(const unsigned*, const void*);
+void indexseq(const unsigned*, const void*);
+void pairseq(const unsigned*, const void*);
 void arginit(const unsigned*, void*);
+void argbinary(const unsigned*, void*);
 void argfree(void*);
+void argpop(const unsigned*, unsigned, void*);
+void argcomplex(const unsigned*, void*);
+bool argpushcomplex(const unsigned*, unsigned, void*);
 bool realcorrs(const void*);
 bool psdtest(const void*);
+bool filtertest(const void*);
+bool realpsdtest(const void*);
+bool symtest(const void*);
+bool complexpsdtest(const void*);
 
 /* additional functions */
-double **Psdtable(unsigned);
+double *Psdtable(unsigned);
+void Argalloc(args_t*, unsigned);
 void Argfree(args_t*);
 void Neckfree(neck_t*);
+const kernel_t *Kernel(unsigned);
+void Argkernel(neck_t*);
+void Argsym(neck_t*, args_t*, bool);
+void Argcomplex(neck_t*, args_t*);
 
 # endif
@@ -0,0 +1,154 @@
+/**
+ * @file iter.c
+ *
+ * @brief Test of the iterative generators against the recursions.
+ *
+ * For every content class of A (bracelets, see Braceletiter) and of B
+ * (necklaces, see Necklaceiter) of a few lengths, the strings returned by the
+ * iterator must be those printed by the recursion (FCBracelet, FCNecklace).
+ * The iterator is saved every SAVEEVERY strings, freed and loaded back (see
+ * Itersave and Iterload), so the strings after a round trip are checked too.
+ *
+ * Executable usage: <b><tt>./iter</tt></b> (exit status 0 on success)
+ *
+ * @author Thomas Pender
+ */
+# include <config.h>
+
+/* std headers */
+# include <stdio.h>
+# include <stddef.h>
+# include <stdlib.h>
+# include <stdbool.h>
+# include <string.h>
+# include <error.h>
+# include <errno.h>
+
+/* project headers */
+# include <defs.h>
+# include <legendre.h>
+
+# define SAVEEVERY 7 ///< number of strings between two saves of an iterator
+
+/** @cond */
+
+typedef struct {
+  unsigned n;
+  size_t count, cap;
+  unsigned *seqs; /* n letters per string */
+} list_t;
+
+static list_t printed; /* strings printed by the recursion */
+
+static
+void listadd(list_t *L, const unsigned *a)
+{
+  if (L->count==L->cap) {
+    L->cap=L->cap==0 ? 1024 : 2*L->cap;
+    L->seqs=(unsigned*)realloc(L->seqs,L->cap*L->n*sizeof(unsigned));
+    if (L->seqs==NULL) error(1, errno, "realloc failed");
+  }
+  memcpy(L->seqs+L->count++*L->n,a+1,L->n*sizeof(unsigned));
+}
+
+static
+void collect(const unsigned *a, const void *_args)
+{
+  (void)_args;
+  listadd(&printed,a);
+}
+
+static unsigned cmplen;
+
+static
+int seqcmp(const void *x, const void *y)
+{
+  return memcmp(x,y,cmplen*sizeof(unsigned));
+}
+
+/* whether two lists hold the same strings (the binary class of A is
+   generated on machine words, in an order of its own) */
+static
+bool listequal(list_t *L, list_t *M)
+{
+  if (L->count!=M->count) return false;
+  if (L->count==0) return true;
+  cmplen=L->n;
+  qsort(L->seqs,L->count,L->n*sizeof(unsigned),seqcmp);
+  qsort(M->seqs,M->count,M->n*sizeof(unsigned),seqcmp);
+  return memcmp(L->seqs,M->seqs,L->count*L->n*sizeof(unsigned))==0;
+}
+
+typedef void (*classinit_t)(unsigned, unsigned, neck_t*, args_t*);
+
+/* one content class: recursion, then iterator with save/load round trips */
+static
+bool testclass(unsigned n, unsigned c, classinit_t classinit, bool bracelet)
+{
+  neck_t neck;
+  args_t args;
+  list_t pulled={.n=n};
+  const unsigned *a;
+  iter_t *it;
+  FILE *fp;
+  bool ok;
+
+  printed=(list_t){.n=n};
+  classinit(n,c,&neck,&args);
+  neck.seqprint=collect;
+  if (bracelet) FCBracelet(&neck,&args
+# if HAVE_PTHREAD
+                           ,NULL
+# endif
+                           );
+  else FCNecklace(&neck,&args
+# if HAVE_PTHREAD
+                  ,NULL
+# endif
+                  );
+  Argfree(&args);
+  Neckfree(&neck);
+
+  classinit(n,c,&neck,&args);
+  it=bracelet ? Braceletiter(&neck,NULL,&args) : Necklaceiter(&neck,&args);
+  while ( (a=Iternext(it))!=NULL ) {
+    listadd(&pulled,a);
+    if (pulled.count%SAVEEVERY==0) {
+      if ( (fp=tmpfile())==NULL ) error(1, errno, "tmpfile failed");
+      Itersave(it,fp);
+      Iterfree(it);
+      rewind(fp);
+      it=Iterload(fp,&neck,&args);
+      fclose(fp);
+    }
+  }
+  Iterfree(it);
+  Argfree(&args);
+  Neckfree(&neck);
+
+  ok=listequal(&printed,&pulled);
+  if (!ok)
+    fprintf(stderr,"%s n=%u class %u: %zu strings printed, %zu pulled\n",
+            bracelet ? "bracelets" : "necklaces",n,c,printed.count,
+            pulled.count);
+  free(printed.seqs);
+  free(pulled.seqs);
+  return ok;
+}
+
+/** @endcond */
+
+/**
+ * @brief driver
+ */
+int main(void)
+{
+  bool ok=true;
+  unsigned n, c;
+
+  for (n=6; n<=14; n+=2) {
+    for (c=0; c<Aclasses(n); c++) ok=testclass(n,c,Aclassinit,true) && ok;
+    for (c=0; c<Bclasses(n); c++) ok=testclass(n,c,Bclassinit,false) && ok;
+  }
+  exit(ok ? 0 : 1);
+}